@@ -1,5 +1,5 @@
 #include <string.h>
-#include <a2blocked.h>
+#include "a2blocked.h"
 #include "uarray2b.h"
 
 // define a private version of each function in A2Methods_T that we implement
@@ -8,7 +8,7 @@ typedef A2Methods_UArray2 A2;   // private abbreviation
 
 static A2 new(int width, int height, int size)
 {
-        return UArray2b_new_64K_block(width, height, size);
+        return UArray2b_new_auto_block(width, height, size);
 }
 
 static A2 new_with_blocksize(int width, int height, int size, int blocksize)
@@ -50,6 +50,11 @@ static void map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
         UArray2b_map(array2, (applyfun *) apply, cl);
 }
 
+static void par_map_block_major(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        UArray2b_par_map(array2, (applyfun *) apply, cl);
+}
+
 struct small_closure {
         A2Methods_smallapplyfun *apply;
         void *cl;
@@ -71,6 +76,73 @@ static void small_map_block_major(A2 a2, A2Methods_smallapplyfun apply,
         UArray2b_map(a2, apply_small, &mycl);
 }
 
+struct tile_closure {
+        A2 array2;
+        A2Methods_tileapplyfun *apply;
+        void *cl;
+};
+
+static void apply_tile(int col, int row, int width, int height, void *base,
+                       int col_stride, int row_stride, void *vcl)
+{
+        struct tile_closure *cl = vcl;
+        A2Methods_Tile tile = { col, row, width, height, base, 
+                                col_stride, row_stride };
+        cl->apply(cl->array2, &tile, cl->cl);
+}
+
+static void map_blocks(A2 array2, A2Methods_tileapplyfun apply, void *cl)
+{
+        struct tile_closure mycl = { array2, apply, cl };
+        UArray2b_map_blocks(array2, apply_tile, &mycl);
+}
+
+typedef void runfun(int i, int j, int down, UArray2b_T array2b, void *base,
+                    int count, void *cl);
+
+static void map_runs(A2 array2, A2Methods_runapplyfun apply, void *cl)
+{
+        UArray2b_map_runs(array2, (runfun *) apply, cl);
+}
+
+struct small_run_closure {
+        A2Methods_smallrunapplyfun *apply;
+        void *cl;
+};
+
+static void apply_small_run(int i, int j, int down, UArray2b_T array2b, 
+                            void *base, int count, void *vcl)
+{
+        struct small_run_closure *cl = vcl;
+        (void)i;
+        (void)j;
+        (void)down;
+        (void)array2b;
+        cl->apply(base, count, cl->cl);
+}
+
+static void small_map_runs(A2 array2, A2Methods_smallrunapplyfun apply, 
+                           void *cl)
+{
+        struct small_run_closure mycl = { apply, cl };
+        UArray2b_map_runs(array2, apply_small_run, &mycl);
+}
+
+static A2 view(A2 array2, int i, int j, int width, int height)
+{
+        return UArray2b_view(array2, i, j, width, height);
+}
+
+static void transform(A2 src, A2 dst, Dihedral_op op)
+{
+        UArray2b_transform(src, dst, op);
+}
+
+static void transform_in_place(A2 array2, Dihedral_op op)
+{
+        UArray2b_transform_in_place(array2, op);
+}
+
 static struct A2Methods_T uarray2_methods_blocked_struct = {
         new,
         new_with_blocksize,
@@ -88,6 +160,18 @@ static struct A2Methods_T uarray2_methods_blocked_struct = {
         NULL,                   // small_map_col_major
         small_map_block_major,
         small_map_block_major,  // small_map_default
+        map_blocks,
+        NULL,                   // row_span (rows are split across blocks)
+        NULL,                   // col_span
+        view,
+        NULL,                   // wrap
+        NULL,                   // par_map_row_major
+        NULL,                   // par_map_col_major
+        par_map_block_major,
+        transform,
+        map_runs,
+        small_map_runs,
+        transform_in_place,
 };
 
 // finally the payoff: here is the exported pointer to the struct
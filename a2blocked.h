@@ -0,0 +1,7 @@
+#ifndef A2BLOCKED_INCLUDED
+#define A2BLOCKED_INCLUDED
+#include "a2methods.h"
+
+extern A2Methods_T uarray2_methods_blocked; // functions for blocked arrays
+
+#endif
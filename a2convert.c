@@ -0,0 +1,237 @@
+/*
+ *     a2convert.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of copying between A2Methods layouts. The
+ *              rows of the array are cut into bands as tall as the larger
+ *              blocksize, so every band of the array with that blocksize is
+ *              a whole row of its blocks, and the bands are handed to 
+ *              Parmap_run. Within a band the tiles of one array are visited
+ *              in storage order and the other array is reached through its
+ *              row spans.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "a2convert.h"
+#include "parmap.h"
+
+typedef A2Methods_UArray2 A2;   /* private abbreviation */
+
+/*
+ * closure for a conversion: the two arrays with their suites, the cell
+ * size and the number of rows in each band
+ */
+struct convert {
+        A2Methods_T to;
+        A2 dst;
+        A2Methods_T from;
+        A2 src;
+        int size;
+        int band;
+};
+
+/* 
+ * copies the cells of copy_line one at a time; with a constant SIZE the 
+ * compiler turns each memcpy into a few moves
+ */
+#define COPY_CELLS(SIZE) do {                                   \
+        for (int k = 0; k < count; k++) {                       \
+                memcpy(out, in, SIZE);                          \
+                out += out_stride;                              \
+                in += in_stride;                                \
+        }                                                       \
+} while (0)
+
+/**********copy_line********
+ *
+ * Copies count cells of size bytes from in, stepping in_stride bytes, to
+ * out, stepping out_stride bytes. A line contiguous on both sides is copied
+ * with a single memcpy, and strided lines of the common cell sizes (such as
+ * the 12 bytes of a Pnm_rgb) with a loop specialized for the size.
+ ************************/
+static void copy_line(char *out, int out_stride, const char *in,
+                      int in_stride, int count, int size)
+{
+        if (out_stride == size && in_stride == size) {
+                memcpy(out, in, (size_t)count * size);
+                return;
+        }
+        switch (size) {
+        case 4:
+                COPY_CELLS(4);
+                break;
+        case 8:
+                COPY_CELLS(8);
+                break;
+        case 12:
+                COPY_CELLS(12);
+                break;
+        case 16:
+                COPY_CELLS(16);
+                break;
+        default:
+                COPY_CELLS(size);
+                break;
+        }
+}
+
+/**********tile_to_rows********
+ *
+ * Tile apply function for the source array: copies each row of the tile to
+ * the matching part of a row of the destination, found through its row span
+ ************************/
+static void tile_to_rows(A2 src, const A2Methods_Tile *tile, void *vcl)
+{
+        struct convert *cv = vcl;
+        (void)src;
+        for (int j = 0; j < tile->height; j++) {
+                A2Methods_Span row;
+                cv->to->row_span(cv->dst, tile->row + j, &row);
+                copy_line((char *)row.base + (size_t)tile->col * row.stride,
+                          row.stride,
+                          (char *)tile->base + (size_t)j * tile->row_stride,
+                          tile->col_stride, tile->width, cv->size);
+        }
+}
+
+/**********rows_to_tile********
+ *
+ * Tile apply function for the destination array: fills each row of the
+ * tile from the matching part of a row of the source, found through its
+ * row span
+ ************************/
+static void rows_to_tile(A2 dst, const A2Methods_Tile *tile, void *vcl)
+{
+        struct convert *cv = vcl;
+        (void)dst;
+        for (int j = 0; j < tile->height; j++) {
+                A2Methods_Span row;
+                cv->from->row_span(cv->src, tile->row + j, &row);
+                copy_line((char *)tile->base + (size_t)j * tile->row_stride,
+                          tile->col_stride,
+                          (char *)row.base + (size_t)tile->col * row.stride,
+                          row.stride, tile->width, cv->size);
+        }
+}
+
+/**********copy_cell********
+ *
+ * Apply function for the destination array of a conversion between suites
+ * that have neither tiles nor row spans: copies one cell from the source
+ ************************/
+static void copy_cell(int i, int j, A2 dst, void *elem, void *vcl)
+{
+        struct convert *cv = vcl;
+        (void)dst;
+        memcpy(elem, cv->from->at(cv->src, i, j), cv->size);
+}
+
+/**********copy_all********
+ *
+ * Copies the whole of cv->src to cv->dst on the calling thread, walking
+ * whichever array is tiled and reaching the other through its row spans
+ ************************/
+static void copy_all(struct convert *cv)
+{
+        if (cv->to->row_span != NULL && cv->from->map_blocks != NULL) {
+                cv->from->map_blocks(cv->src, tile_to_rows, cv);
+        } else if (cv->from->row_span != NULL && cv->to->map_blocks != NULL) {
+                cv->to->map_blocks(cv->dst, rows_to_tile, cv);
+        } else {
+                cv->to->map_default(cv->dst, copy_cell, cv);
+        }
+}
+
+/**********copy_band********
+ *
+ * Parmap task that copies band index: views of the same rows of the source
+ * and the destination are converted on their own and then freed
+ ************************/
+static void copy_band(int index, void *vcl)
+{
+        const struct convert *cv = vcl;
+        int width = cv->from->width(cv->src);
+        int height = cv->from->height(cv->src);
+        int row = index * cv->band;
+        int rows = height - row < cv->band ? height - row : cv->band;
+
+        struct convert band = *cv;
+        band.src = cv->from->view(cv->src, 0, row, width, rows);
+        band.dst = cv->to->view(cv->dst, 0, row, width, rows);
+        copy_all(&band);
+        cv->from->free(&band.src);
+        cv->to->free(&band.dst);
+}
+
+/**********A2convert_copy********
+ *
+ * Copies every cell of one array to the same place in an array of another
+ * (or the same) layout
+ * Inputs:
+ *              A2Methods_T to: the methods suite of dst
+ *              A2Methods_UArray2 dst: the array that receives the cells
+ *              A2Methods_T from: the methods suite of src
+ *              A2Methods_UArray2 src: the array to copy
+ * Return: N/A
+ * Expects:
+ *      * the suites and arrays to be nonnull and the arrays distinct
+ *      * dst to have the dimensions and cell size of src
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * Bands are as tall as the larger of the two blocksizes (1 for a
+ *        plain array), so each band of the array with the larger blocksize
+ *        starts at the top of a row of its blocks. The other array's bands
+ *        need not line up with its blocks (blocksizes 16 and 24 give bands
+ *        that start mid-block at row 24), so two tasks may share one of its
+ *        blocks, but never a cell: each task writes only its own rows
+ *      * Without views in both suites the copy is done on the calling
+ *        thread in a single pass
+ ************************/
+void A2convert_copy(A2Methods_T to, A2 dst, A2Methods_T from, A2 src)
+{
+        assert(to != NULL && from != NULL);
+        assert(dst != NULL && src != NULL && dst != src);
+        int width = from->width(src);
+        int height = from->height(src);
+        assert(to->width(dst) == width && to->height(dst) == height);
+        assert(to->size(dst) == from->size(src));
+
+        int band = from->blocksize(src);
+        if (to->blocksize(dst) > band) {
+                band = to->blocksize(dst);
+        }
+        struct convert cv = { to, dst, from, src, from->size(src), band };
+        if (width == 0 || height == 0) {
+                return;
+        } else if (to->view == NULL || from->view == NULL) {
+                copy_all(&cv);
+                return;
+        }
+        Parmap_run((height + band - 1) / band, copy_band, &cv);
+}
+
+/**********A2convert_new********
+ *
+ * Returns a new array of the suite to, with the dimensions and cell size of
+ * src, holding a copy of src
+ * Inputs:
+ *              A2Methods_T to: the methods suite of the new array
+ *              A2Methods_T from: the methods suite of src
+ *              A2Methods_UArray2 src: the array to copy
+ * Return: the new array, which the caller frees with to->free
+ * Expects:
+ *      * the suites and src to be nonnull
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ ************************/
+A2 A2convert_new(A2Methods_T to, A2Methods_T from, A2 src)
+{
+        assert(to != NULL && from != NULL && src != NULL);
+        A2 dst = to->new(from->width(src), from->height(src),
+                         from->size(src));
+        A2convert_copy(to, dst, from, src);
+        return dst;
+}
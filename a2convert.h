@@ -0,0 +1,38 @@
+/*
+ *     a2convert.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for copying a 2D array from one A2Methods layout
+ *              into another (plain to blocked, blocked to plain, or any
+ *              other pair), a run of cells at a time and in parallel, so a
+ *              program can read an image in one layout and transform or
+ *              write it in another
+ */
+
+#ifndef A2CONVERT_INCLUDED
+#define A2CONVERT_INCLUDED
+
+#include "a2methods.h"
+
+/*
+ * Copies every cell of src, an array of the suite from, to the same column
+ * and row of dst, an array of the suite to. The arrays must be distinct
+ * and have the same dimensions and cell size (checked runtime error
+ * otherwise); either may be a view. The copy is split into bands of rows
+ * that are run on up to Parmap_threads() threads when both suites can make
+ * views. Each band is copied one tile of the tiled array at a time, moving
+ * whole lines of cells to or from the rows of the other array when one of
+ * the suites describes rows as spans, and cell by cell otherwise.
+ */
+extern void A2convert_copy(A2Methods_T to, A2Methods_UArray2 dst,
+                           A2Methods_T from, A2Methods_UArray2 src);
+
+/*
+ * Returns a new array of the suite to, made with to->new, that holds a
+ * copy of src, an array of the suite from
+ */
+extern A2Methods_UArray2 A2convert_new(A2Methods_T to, A2Methods_T from,
+                                       A2Methods_UArray2 src);
+
+#endif
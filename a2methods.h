@@ -0,0 +1,200 @@
+#ifndef A2METHODS_INCLUDED
+#define A2METHODS_INCLUDED
+
+#include "dihedral.h"
+
+/*
+ * Polymorphic interface to two-dimensional unboxed arrays.
+ *
+ * This is the course interface with additional, optional operations
+ * appended to the end of struct A2Methods_T. Because the original members
+ * keep their order, code compiled against the course header (such as
+ * Pnm_ppmread) still works with the suites defined here. A suite that does
+ * not support an optional operation sets its pointer to NULL.
+ */
+
+typedef void *A2Methods_UArray2;    // an unknown sort of array
+
+typedef void A2Methods_Object;      // an unknown sort of element
+
+/*
+ * apply function for full mapping functions: i is the column, j the row,
+ * array2 the array being mapped and ptr the element at (i, j)
+ */
+typedef void A2Methods_applyfun(int i, int j, A2Methods_UArray2 array2,
+                                A2Methods_Object *ptr, void *cl);
+typedef void A2Methods_mapfun(A2Methods_UArray2 array2,
+                              A2Methods_applyfun apply, void *cl);
+
+/* apply function for small mapping functions: just the element and cl */
+typedef void A2Methods_smallapplyfun(A2Methods_Object *ptr, void *cl);
+typedef void A2Methods_smallmapfun(A2Methods_UArray2 a2,
+                                   A2Methods_smallapplyfun f, void *cl);
+
+/*
+ * A tile is a rectangle of cells stored at regular strides: the cell at
+ * (col + i, row + j) is at (char *)base + i * col_stride + j * row_stride
+ * for 0 <= i < width and 0 <= j < height. Strides are in bytes. Tiles on
+ * the right and bottom edges of an array are already clipped to the cells
+ * that exist.
+ */
+typedef struct A2Methods_Tile {
+        int col, row;                   // top left cell of the tile
+        int width, height;              // number of valid columns and rows
+        A2Methods_Object *base;         // the element at (col, row)
+        int col_stride;                 // bytes from (i, j) to (i + 1, j)
+        int row_stride;                 // bytes from (i, j) to (i, j + 1)
+} A2Methods_Tile;
+
+/*
+ * A span is a line of count cells: the kth cell is at 
+ * (char *)base + k * stride, with the stride in bytes. A span whose stride 
+ * equals the cell size is contiguous and can be moved with memcpy.
+ */
+typedef struct A2Methods_Span {
+        A2Methods_Object *base;         // the first cell
+        int count;                      // number of cells
+        int stride;                     // bytes from one cell to the next
+} A2Methods_Span;
+
+/*
+ * apply function for run mapping functions: called once per run of count 
+ * cells that are contiguous in memory, the kth at (char *)base + k * size.
+ * The run starts at column i, row j and goes along the row (cells 
+ * (i + k, j)), or down the column (cells (i, j + k)) if down is nonzero.
+ */
+typedef void A2Methods_runapplyfun(int i, int j, int down, 
+                                   A2Methods_UArray2 array2,
+                                   A2Methods_Object *base, int count, 
+                                   void *cl);
+typedef void A2Methods_runmapfun(A2Methods_UArray2 array2,
+                                 A2Methods_runapplyfun apply, void *cl);
+
+/* apply function for small run mapping functions: just the run and cl */
+typedef void A2Methods_smallrunapplyfun(A2Methods_Object *base, int count, 
+                                        void *cl);
+typedef void A2Methods_smallrunmapfun(A2Methods_UArray2 array2,
+                                      A2Methods_smallrunapplyfun apply, 
+                                      void *cl);
+
+/* apply function for tile mapping functions: called once per tile */
+typedef void A2Methods_tileapplyfun(A2Methods_UArray2 array2,
+                                    const A2Methods_Tile *tile, void *cl);
+typedef void A2Methods_tilemapfun(A2Methods_UArray2 array2,
+                                  A2Methods_tileapplyfun apply, void *cl);
+
+typedef const struct A2Methods_T {
+        // creates a distinct 2D array of memory cells, each of the given size
+        // each cell is uninitialized
+        // if the array is blocked, uses a default block size
+        A2Methods_UArray2 (*new)(int width, int height, int size);
+
+        // creates a distinct 2D array of memory cells, each of the given size
+        // each cell is uninitialized
+        // if the array is blocked, the block size is given;
+        // otherwise, the block size is ignored
+        A2Methods_UArray2 (*new_with_blocksize)(int width, int height,
+                                                int size, int blocksize);
+
+        // frees *array2p and overwrites the pointer with NULL
+        void (*free)(A2Methods_UArray2 *array2p);
+
+        // observe properties of the array
+        int (*width)    (A2Methods_UArray2 array2);
+        int (*height)   (A2Methods_UArray2 array2);
+        int (*size)     (A2Methods_UArray2 array2);
+        int (*blocksize)(A2Methods_UArray2 array2);  // 1 for unblocked arrays
+
+        // returns a pointer to the object in column i, row j
+        // (checked runtime error if i or j is out of bounds)
+        A2Methods_Object *(*at)(A2Methods_UArray2 array2, int i, int j);
+
+        // mapping functions
+        // it is a checked runtime error to pass a NULL function pointer,
+        // and some mapping functions may be NULL.  But
+        //   - Every implementation must have a default map.
+        //   - Implementations of blocked arrays must have block-major maps
+        //   - Implementations of plain arrays must have row-major and
+        //     column-major maps
+        A2Methods_mapfun *map_row_major;
+        A2Methods_mapfun *map_col_major;
+        A2Methods_mapfun *map_block_major;
+        A2Methods_mapfun *map_default;  // default map is the best for
+                                        // locality
+
+        // mapping functions that do not pass the index or the array
+        A2Methods_smallmapfun *small_map_row_major;
+        A2Methods_smallmapfun *small_map_col_major;
+        A2Methods_smallmapfun *small_map_block_major;
+        A2Methods_smallmapfun *small_map_default;
+
+        /* - - - - - - - - - optional operations - - - - - - - - - */
+
+        // calls apply once per tile of the layout (a block of a blocked
+        // array, the whole array for a plain one), in storage order
+        A2Methods_tilemapfun *map_blocks;
+
+        // describe row j (or column i) of the array as a span
+        // (checked runtime error if i or j is out of bounds); only layouts 
+        // that store rows or columns at a fixed stride provide these
+        void (*row_span)(A2Methods_UArray2 array2, int j,
+                         A2Methods_Span *span);
+        void (*col_span)(A2Methods_UArray2 array2, int i,
+                         A2Methods_Span *span);
+
+        // creates a view of the width x height window of array2 whose top 
+        // left cell is (i, j), sharing array2's cells: (k, l) of the view is
+        // (i + k, j + l) of array2. Every operation of the suite accepts the
+        // view; freeing it leaves the cells alone, and it must be freed 
+        // before array2 is (checked runtime error if the window does not lie
+        // inside array2)
+        A2Methods_UArray2 (*view)(A2Methods_UArray2 array2, int i, int j,
+                                  int width, int height);
+
+        // creates a 2D array over an existing buffer without copying it: 
+        // the cell in column i, row j is at (char *)elems + j * pitch + 
+        // i * size. Freeing the array calls release(elems, cl) unless 
+        // release is NULL. Only layouts that store rows at a fixed pitch 
+        // provide this.
+        A2Methods_UArray2 (*wrap)(void *elems, int width, int height, 
+                                  int size, int pitch, 
+                                  void release(void *elems, void *cl),
+                                  void *cl);
+
+        // parallel mapping functions: like the maps above, but apply is 
+        // called from several threads at once (see parmap.h for setting how
+        // many), each working through its own bands of rows or columns, or 
+        // its own blocks, and stealing from the others when it runs out. 
+        // apply must be safe to call concurrently for different elements, 
+        // and the overall order of the calls is unspecified.
+        A2Methods_mapfun *par_map_row_major;
+        A2Methods_mapfun *par_map_col_major;
+        A2Methods_mapfun *par_map_block_major;
+
+        // copies every cell of src to its place in dst under op, one of the
+        // eight symmetries of a rectangle (see dihedral.h). dst must come 
+        // from the same suite, be distinct from src, have the same cell size
+        // and have src's dimensions, swapped if Dihedral_swaps(op) (checked
+        // runtime error otherwise). The layout picks the loop order that 
+        // suits both arrays, scattering from src or gathering into dst.
+        void (*transform)(A2Methods_UArray2 src, A2Methods_UArray2 dst,
+                          Dihedral_op op);
+
+        // visit every cell once, calling apply once per contiguous run of
+        // cells (a row of a plain array, a column or row of a block of a 
+        // blocked one) in storage order, so a client can loop over the run
+        // itself instead of taking a call per cell
+        A2Methods_runmapfun *map_runs;
+        A2Methods_smallrunmapfun *small_map_runs;
+
+        // moves every cell of array2 to its place under op without a 
+        // second array, by swapping each cell with the one op sends it to.
+        // Every layout that has it takes the ops that keep the dimensions
+        // (a flip, the half turn or the identity), on views too. The plain
+        // layout also takes the ops that swap them, which reshape array2:
+        // any array that is not a view, and square views. Other ops are a
+        // checked runtime error.
+        void (*transform_in_place)(A2Methods_UArray2 array2, Dihedral_op op);
+} *A2Methods_T;
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ *     a2morton.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implements a A2Methods_T methods suite using the Morton-ordered
+ *              UArray2m interface. The layout is recursive, so its only
+ *              mapping function walks the Z-order curve and is exported as
+ *              both the block-major and the default map.
+ */
+
+#include <string.h>
+#include "a2morton.h"
+#include "uarray2m.h"
+
+// define a private version of each function in A2Methods_T that we implement
+
+typedef A2Methods_UArray2 A2;   // private abbreviation
+
+static A2 new(int width, int height, int size)
+{
+        return UArray2m_new(width, height, size);
+}
+
+static A2 new_with_blocksize(int width, int height, int size, int blocksize)
+{
+        (void) blocksize;
+        return UArray2m_new(width, height, size);
+}
+
+static void a2free(A2 * array2p)
+{
+        UArray2m_free((UArray2m_T *) array2p);
+}
+
+static int width(A2 array2)
+{
+        return UArray2m_width(array2);
+}
+static int height(A2 array2)
+{
+        return UArray2m_height(array2);
+}
+static int size(A2 array2)
+{
+        return UArray2m_size(array2);
+}
+
+/* a Z-order layout has no single blocksize; every power of two is a block */
+static int blocksize(A2 array2)
+{
+        (void) array2;
+        return 1;
+}
+
+static A2Methods_Object *at(A2 array2, int i, int j)
+{
+        return UArray2m_at(array2, i, j);
+}
+
+typedef void applyfun(int i, int j, UArray2m_T array2m, void *elem, void *cl);
+
+static void map_morton(A2 array2, A2Methods_applyfun apply, void *cl)
+{
+        UArray2m_map(array2, (applyfun *) apply, cl);
+}
+
+struct small_closure {
+        A2Methods_smallapplyfun *apply;
+        void *cl;
+};
+
+static void apply_small(int i, int j, UArray2m_T array2, void *elem, void *vcl)
+{
+        struct small_closure *cl = vcl;
+        (void)i;
+        (void)j;
+        (void)array2;
+        cl->apply(elem, cl->cl);
+}
+
+static void small_map_morton(A2 a2, A2Methods_smallapplyfun apply, void *cl)
+{
+        struct small_closure mycl = { apply, cl };
+        UArray2m_map(a2, apply_small, &mycl);
+}
+
+static void transform(A2 src, A2 dst, Dihedral_op op)
+{
+        UArray2m_transform(src, dst, op);
+}
+
+static struct A2Methods_T uarray2_methods_morton_struct = {
+        new,
+        new_with_blocksize,
+        a2free,
+        width,
+        height,
+        size,
+        blocksize,
+        at,
+        NULL,                   // map_row_major
+        NULL,                   // map_col_major
+        map_morton,             // map_block_major
+        map_morton,             // map_default
+        NULL,                   // small_map_row_major
+        NULL,                   // small_map_col_major
+        small_map_morton,       // small_map_block_major
+        small_map_morton,       // small_map_default
+        NULL,                   // map_blocks (cells are not strided)
+        NULL,                   // row_span
+        NULL,                   // col_span
+        NULL,                   // view
+        NULL,                   // wrap
+        NULL,                   // par_map_row_major
+        NULL,                   // par_map_col_major
+        NULL,                   // par_map_block_major
+        transform,
+        NULL,                   // map_runs
+        NULL,                   // small_map_runs
+        NULL,                   // transform_in_place
+};
+
+// finally the payoff: here is the exported pointer to the struct
+
+A2Methods_T uarray2_methods_morton = &uarray2_methods_morton_struct;
@@ -0,0 +1,16 @@
+/*
+ *     a2morton.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Exports the A2Methods_T methods suite built on the 
+ *              Morton-ordered UArray2m interface
+ */
+
+#ifndef A2MORTON_INCLUDED
+#define A2MORTON_INCLUDED
+#include "a2methods.h"
+
+extern A2Methods_T uarray2_methods_morton;
+
+#endif
@@ -8,7 +8,8 @@
  */
 
 #include <string.h>
-#include <a2plain.h>
+#include <assert.h>
+#include "a2plain.h"
 #include "uarray2.h"
 
 
@@ -288,6 +289,309 @@ static void map_col_major(A2Methods_UArray2 uarray2,
         UArray2_map_col_major(uarray2, (UArray2_applyfun*)apply, cl);
 }
 
+/**********par_map_row_major********
+ *
+ * Calls an apply function for each element in the argued A2 from several 
+ * threads, each visiting bands of rows in row-major order
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The A2 instance that the apply 
+ *                          function will be called on 
+ *              A2Methods_applyfun apply: The function that will be applied to 
+ *                          each element in uarray2
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ *      * apply to be safe to call concurrently for different elements
+ * Notes:
+ *      Checked runtime errors are raised through UArray2_par_map_row_major
+ ************************/
+static void par_map_row_major(A2Methods_UArray2 uarray2,
+                              A2Methods_applyfun apply,
+                              void *cl)
+{
+        UArray2_par_map_row_major(uarray2, (UArray2_applyfun*)apply, cl);
+}
+
+/**********par_map_col_major********
+ *
+ * Calls an apply function for each element in the argued A2 from several 
+ * threads, each visiting bands of columns in column-major order
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The A2 instance that the apply 
+ *                          function will be called on 
+ *              A2Methods_applyfun apply: The function that will be applied to 
+ *                          each element in uarray2
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ *      * apply to be safe to call concurrently for different elements
+ * Notes:
+ *      Checked runtime errors are raised through UArray2_par_map_col_major
+ ************************/
+static void par_map_col_major(A2Methods_UArray2 uarray2,
+                              A2Methods_applyfun apply,
+                              void *cl)
+{
+        UArray2_par_map_col_major(uarray2, (UArray2_applyfun*)apply, cl);
+}
+
+/**********map_blocks********
+ *
+ * Calls a tile apply function once for the argued A2. A plain array is a 
+ * single tile: its cells are size bytes apart within a row and one row pitch
+ * (see UArray2_pitch) apart within a column.
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: A pointer to the A2 instance that 
+ *                          the apply function will be called on 
+ *              A2Methods_tileapplyfun apply: The function that will be 
+ *                          applied to the tile
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ * Notes:
+ *      An empty UArray2 has no tiles, so apply is not called for it
+ ************************/
+static void map_blocks(A2Methods_UArray2 uarray2,
+                       A2Methods_tileapplyfun apply,
+                       void *cl)
+{
+        int w = UArray2_width(uarray2);
+        int h = UArray2_height(uarray2);
+        if (w == 0 || h == 0) {
+                return;
+        }
+        A2Methods_Tile tile = { 0, 0, w, h, UArray2_at(uarray2, 0, 0),
+                                UArray2_size(uarray2), 
+                                UArray2_pitch(uarray2) };
+        apply(uarray2, &tile, cl);
+}
+
+/**********row_span********
+ *
+ * Describes a row of the argued A2 as a span. Rows of a UArray2 are 
+ * contiguous, so the stride is the element size.
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The UArray2 holding the row
+ *              int row: The row index within the UArray2
+ *              A2Methods_Span *span: Where the description is stored
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 and span to be nonnull
+ *      * The row value is nonnegative and is less than the height of the 
+ *        UArray2
+ * Notes:
+ *      Checked runtime errors are raised through UArray2_row
+ ************************/
+static void row_span(A2Methods_UArray2 uarray2, int row, A2Methods_Span *span)
+{
+        assert(span != NULL);
+        span->base = UArray2_row(uarray2, row);
+        span->count = UArray2_width(uarray2);
+        span->stride = UArray2_size(uarray2);
+}
+
+/**********col_span********
+ *
+ * Describes a column of the argued A2 as a span, whose cells are one row 
+ * pitch apart
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The UArray2 holding the column
+ *              int col: The column index within the UArray2
+ *              A2Methods_Span *span: Where the description is stored
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 and span to be nonnull
+ *      * The col value is nonnegative and is less than the width of the 
+ *        UArray2
+ * Notes:
+ *      * Checked runtime error if span is null or col is out of bounds
+ *      * An empty column (height 0) has a NULL base
+ ************************/
+static void col_span(A2Methods_UArray2 uarray2, int col, A2Methods_Span *span)
+{
+        assert(span != NULL);
+        assert(col >= 0 && col < UArray2_width(uarray2));
+        int h = UArray2_height(uarray2);
+        span->base = h > 0 ? UArray2_at(uarray2, col, 0) : NULL;
+        span->count = h;
+        span->stride = UArray2_pitch(uarray2);
+}
+
+/**********view********
+ *
+ * Returns a view of a window of the argued A2 that shares its cells, using 
+ * the UArray2_view function
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The UArray2 to look into
+ *              int col, int row: the top left cell of the window
+ *              int width, int height: the extent of the window
+ * Return: An A2Methods_UArray2, which is a UArray2 view
+ * Expects:
+ *      * the window to lie inside uarray2
+ * Notes:
+ *      * Checked runtime errors are raised through UArray2_view
+ *      * The view must be freed with a2free before uarray2 is
+ ************************/
+static A2Methods_UArray2 view(A2Methods_UArray2 uarray2, int col, int row,
+                              int width, int height)
+{
+        return UArray2_view(uarray2, col, row, width, height);
+}
+
+/**********wrap********
+ *
+ * Returns an A2 over a buffer the caller already holds, using the 
+ * UArray2_wrap function, so an image that is already in memory can be 
+ * transformed with this suite without a copy
+ * Inputs:
+ *              void *elems: the buffer, holding height rows pitch bytes apart
+ *              int width, int height, int size: as for new
+ *              int pitch: bytes from the start of one row to the next
+ *              void release: called with elems and cl when the A2 is freed,
+ *                            or NULL
+ *              void *cl: A closure passed to release
+ * Return: An A2Methods_UArray2, which is a UArray2
+ * Expects:
+ *      * pitch to be at least width * size
+ * Notes:
+ *      * Checked runtime errors are raised through UArray2_wrap
+ ************************/
+static A2Methods_UArray2 wrap(void *elems, int width, int height, int size,
+                              int pitch, void release(void *elems, void *cl),
+                              void *cl)
+{
+        return UArray2_wrap(elems, width, height, size, pitch, release, cl);
+}
+
+/**********transform********
+ *
+ * Copies every cell of the argued source A2 to its place in the destination
+ * A2 under a symmetry of the rectangle, using the UArray2_transform 
+ * function
+ * Inputs:
+ *              A2Methods_UArray2 src: The UArray2 to transform
+ *              A2Methods_UArray2 dst: The UArray2 that receives the cells
+ *              Dihedral_op op: where each cell goes
+ * Return: N/A
+ * Expects:
+ *      * dst to have src's dimensions (swapped if op swaps them) and cell size
+ * Notes:
+ *      * Checked runtime errors are raised through UArray2_transform, which
+ *        chooses between scattering from src and gathering into dst with a 
+ *        cost model
+ ************************/
+static void transform(A2Methods_UArray2 src, A2Methods_UArray2 dst, 
+                      Dihedral_op op)
+{
+        UArray2_transform(src, dst, op);
+}
+
+/**********transform_in_place********
+ *
+ * Moves every cell of the argued A2 to its place under a symmetry of the 
+ * rectangle without a second array, using the UArray2_transform_in_place 
+ * function
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The UArray2 to transform
+ *              Dihedral_op op: where each cell goes
+ * Return: N/A
+ * Expects:
+ *      * uarray2 to be square or not a view if op swaps the dimensions
+ * Notes:
+ *      * Checked runtime errors are raised through 
+ *        UArray2_transform_in_place
+ *      * An op that swaps the dimensions swaps those of uarray2
+ ************************/
+static void transform_in_place(A2Methods_UArray2 uarray2, Dihedral_op op)
+{
+        UArray2_transform_in_place(uarray2, op);
+}
+
+/*
+ * closure used by apply_row to carry a run apply function
+ */
+struct run_closure {
+        A2Methods_runapplyfun *apply;
+        void *cl;
+};
+
+/**********apply_row********
+ *
+ * UArray2_map_rows apply function that hands a row on to a run apply 
+ * function as a run going along the row from column 0
+ ************************/
+static void apply_row(int row, UArray2_T uarray2, void *row_base, int width, 
+                      void *vcl)
+{
+        struct run_closure *cl = vcl;
+        cl->apply(0, row, 0, uarray2, row_base, width, cl->cl);
+}
+
+/**********map_runs********
+ *
+ * Calls a run apply function once for each row of the argued A2, from top
+ * to bottom, using the UArray2_map_rows function. The rows of a UArray2 
+ * are contiguous, so each row is a single run.
+ * Inputs:
+ *              A2Methods_UArray2 uarray2: The A2 instance whose rows will be
+ *                          visited
+ *              A2Methods_runapplyfun apply: The function that will be 
+ *                          applied to each row
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ * Notes:
+ *      Checked runtime errors are raised through UArray2_map_rows
+ ************************/
+static void map_runs(A2Methods_UArray2 uarray2, A2Methods_runapplyfun apply,
+                     void *cl)
+{
+        struct run_closure mycl = { apply, cl };
+        UArray2_map_rows(uarray2, apply_row, &mycl);
+}
+
+/*
+ * closure used by apply_small_row to carry a small run apply function
+ */
+struct small_run_closure {
+        A2Methods_smallrunapplyfun *apply;
+        void *cl;
+};
+
+/**********apply_small_row********
+ *
+ * UArray2_map_rows apply function that hands a row on to a small run apply
+ * function
+ ************************/
+static void apply_small_row(int row, UArray2_T uarray2, void *row_base, 
+                            int width, void *vcl)
+{
+        struct small_run_closure *cl = vcl;
+        (void)row;
+        (void)uarray2;
+        cl->apply(row_base, width, cl->cl);
+}
+
+/**********small_map_runs********
+ *
+ * Like map_runs, but the apply function is given only the run and the 
+ * closing argument
+ ************************/
+static void small_map_runs(A2Methods_UArray2 uarray2, 
+                           A2Methods_smallrunapplyfun apply, void *cl)
+{
+        struct small_run_closure mycl = { apply, cl };
+        UArray2_map_rows(uarray2, apply_small_row, &mycl);
+}
+
 /* 
 * All functions from here onwards are written by COURSE STAFF
 */
@@ -370,6 +674,18 @@ static struct A2Methods_T uarray2_methods_plain_struct = {
         small_map_col_major,  // small_map_col_major
         NULL,
         small_map_row_major,  // small_map_default
+        map_blocks,
+        row_span,
+        col_span,
+        view,
+        wrap,
+        par_map_row_major,
+        par_map_col_major,
+        NULL,                 /* par_map_block_major */
+        transform,
+        map_runs,
+        small_map_runs,
+        transform_in_place,
 };
 
 /* finally the payoff: here is the exported pointer to the struct of this 
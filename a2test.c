@@ -1,16 +1,27 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
+#include "uarray2_impl.h"
+#include "uarray2b_impl.h"
+#include "parmap.h"
+#include "kernels.h"
+#include "a2convert.h"
+#include "simdtile.h"
+#include "resample.h"
 
 
 #define W 13
 #define H 15
 #define BS 4
+#define ODD_BS 5        /* not a power of two, so indexed by division */
 
 static A2Methods_T methods;
+static int blocksize;   /* of the blocked arrays under test */
 typedef A2Methods_UArray2 A2;
 
 static void check_and_increment(int i, int j, A2 a, void *elem, void *cl) 
@@ -37,7 +48,8 @@ static void small_check_and_increment(void *elem, void *cl)
 static void double_row_major_plus()
 {
         /* store increasing integers in row-major order */
-        A2 array = methods->new_with_blocksize(W, H, sizeof(int), BS);
+        A2 array = methods->new_with_blocksize(W, H, sizeof(int), 
+                                               blocksize);
         int counter = 1;
         for (int j = 0; j < H; j++) { 
                 for (int i = 0; i < W; i++) { /* col index varies faster */
@@ -81,6 +93,17 @@ static inline void check(A2 a, int i, int j, unsigned n)
         assert(*p == n);
 }
 
+/* stores 1000 * i + j in each cell (i, j) of an array of suite */
+static void fill_test_values(A2Methods_T suite, A2 a)
+{
+        for (int i = 0; i < suite->width(a); i++) {
+                for (int j = 0; j < suite->height(a); j++) {
+                        unsigned *p = suite->at(a, i, j);
+                        *p = 1000u * i + j;
+                }
+        }
+}
+
 bool has_minimum_methods(A2Methods_T m)
 {
         return m->new != NULL && m->new_with_blocksize != NULL
@@ -113,6 +136,682 @@ bool has_blocked_methods(A2Methods_T m)
         return m->map_default != NULL && m->map_block_major != NULL;
 }
 
+/* checks every cell of a tile holds 1000 * col + row, counting the cells */
+static void check_tile(A2 a, const A2Methods_Tile *tile, void *cl)
+{
+        (void)a;
+        int *counter = cl;
+        for (int i = 0; i < tile->width; i++) {
+                for (int j = 0; j < tile->height; j++) {
+                        unsigned *p = (unsigned *)((char *)tile->base 
+                                                + i * tile->col_stride 
+                                                + j * tile->row_stride);
+                        assert(*p == 1000u * (tile->col + i) 
+                                                + (tile->row + j));
+                        *counter += 1;
+                }
+        }
+}
+
+/* checks the inline unchecked accessors agree with methods->at */
+static void check_unchecked(A2 a)
+{
+        for (int i = 0; i < W; i++) {
+                for (int j = 0; j < H; j++) {
+                        void *p = methods == uarray2_methods_plain
+                                        ? UArray2_at_unchecked(a, i, j)
+                                        : UArray2b_at_unchecked(a, i, j);
+                        assert(p == methods->at(a, i, j));
+                }
+        }
+}
+
+/* checks every row and column span against methods->at */
+static void check_spans(A2 a)
+{
+        for (int j = 0; j < H; j++) {
+                A2Methods_Span span;
+                methods->row_span(a, j, &span);
+                assert(span.count == W);
+                for (int i = 0; i < W; i++) {
+                        assert((char *)span.base + i * span.stride
+                                        == methods->at(a, i, j));
+                }
+        }
+        for (int i = 0; i < W; i++) {
+                A2Methods_Span span;
+                methods->col_span(a, i, &span);
+                assert(span.count == H);
+                for (int j = 0; j < H; j++) {
+                        assert((char *)span.base + j * span.stride
+                                        == methods->at(a, i, j));
+                }
+        }
+}
+
+/* 
+ * checks a cell of a view of the test array holds 1000 * col + row of the
+ * array, where the view's window starts at (VC, VR)
+ */
+#define VC 2
+#define VR 3
+static void check_view_cell(int i, int j, A2 a, void *elem, void *cl)
+{
+        (void)a;
+        int *counter = cl;
+        assert(*(unsigned *)elem == 1000u * (i + VC) + (j + VR));
+        *counter += 1;
+}
+
+/* checks the tiles of a view by shifting them back to the array */
+static void check_view_tile(A2 a, const A2Methods_Tile *tile, void *cl)
+{
+        A2Methods_Tile shifted = *tile;
+        shifted.col += VC;
+        shifted.row += VR;
+        check_tile(a, &shifted, cl);
+}
+
+/* checks a view of the test array sees exactly the cells of its window */
+static void check_view(A2 array)
+{
+        int w = W - VC - 4;
+        int h = H - VR - 2;
+        A2 view = methods->view(array, VC, VR, w, h);
+        assert(methods->width(view) == w && methods->height(view) == h);
+        for (int i = 0; i < w; i++) {
+                for (int j = 0; j < h; j++) {
+                        assert(methods->at(view, i, j) 
+                                        == methods->at(array, i + VC, j + VR));
+                }
+        }
+        int counter = 0;
+        methods->map_default(view, check_view_cell, &counter);
+        assert(counter == w * h);
+        if (methods->map_blocks) {
+                counter = 0;
+                methods->map_blocks(view, check_view_tile, &counter);
+                assert(counter == w * h);
+        }
+        A2 inner = methods->view(view, 1, 1, w - 2, h - 2);
+        assert(methods->at(inner, 0, 0) 
+                                == methods->at(array, VC + 1, VR + 1));
+        methods->free(&inner);
+        methods->free(&view);
+        assert(view == NULL);
+}
+
+/* counts the buffers handed back by wrapped arrays */
+static void count_release(void *elems, void *cl)
+{
+        (void)elems;
+        int *released = cl;
+        *released += 1;
+}
+
+/* checks an array wrapped around a padded buffer sees the buffer's cells */
+static void check_wrap(void)
+{
+        enum { PITCH = W + 3 };
+        unsigned buffer[H][PITCH];
+        for (int j = 0; j < H; j++) {
+                for (int i = 0; i < PITCH; i++) {
+                        buffer[j][i] = i < W ? 1000u * i + j : 0xdead;
+                }
+        }
+        int released = 0;
+        A2 array = methods->wrap(buffer, W, H, sizeof(unsigned), 
+                                 PITCH * sizeof(unsigned), count_release,
+                                 &released);
+        for (int i = 0; i < W; i++) {
+                for (int j = 0; j < H; j++) {
+                        assert(methods->at(array, i, j) == &buffer[j][i]);
+                }
+        }
+        int counter = 0;
+        methods->map_blocks(array, check_tile, &counter);
+        assert(counter == W * H);
+        methods->free(&array);
+        assert(released == 1);
+}
+
+/* adds one to a cell; safe to call concurrently for different cells */
+static void bump(int i, int j, A2 a, void *elem, void *cl)
+{
+        (void)i;
+        (void)j;
+        (void)a;
+        (void)cl;
+        *(unsigned *)elem += 1;
+}
+
+/* checks each parallel map the suite has visits every cell exactly once */
+static void check_par_maps(A2 array)
+{
+        A2Methods_mapfun *maps[] = { methods->par_map_row_major, 
+                                     methods->par_map_col_major, 
+                                     methods->par_map_block_major };
+        int nmaps = sizeof(maps) / sizeof(maps[0]);
+        unsigned bumps = 0;
+        Parmap_set_threads(4);
+        for (int k = 0; k < nmaps; k++) {
+                if (maps[k] != NULL) {
+                        maps[k](array, bump, NULL);
+                        bumps++;
+                }
+        }
+        for (int i = 0; i < W; i++) {
+                for (int j = 0; j < H; j++) {
+                        unsigned *p = methods->at(array, i, j);
+                        assert(*p == 1000u * i + j + bumps);
+                        *p -= bumps;
+                }
+        }
+}
+
+/* 
+ * checks each cell of a run is where at says and holds the test value of 
+ * the array cell (i + ci, j + cj) it shows, and counts the cells
+ */
+static void check_run_cells(int i, int j, int down, A2 a, void *base, 
+                            int count, int ci, int cj, int *counter)
+{
+        assert(count > 0);
+        for (int k = 0; k < count; k++) {
+                int c = down ? i : i + k;
+                int r = down ? j + k : j;
+                unsigned *p = (unsigned *)base + k;
+                assert((void *)p == methods->at(a, c, r));
+                assert(*p == 1000u * (c + ci) + r + cj);
+        }
+        *counter += count;
+}
+
+static void check_run(int i, int j, int down, A2 a, void *base, int count,
+                      void *cl)
+{
+        check_run_cells(i, j, down, a, base, count, 0, 0, cl);
+}
+
+/* checks a run of a view of the test array whose window is at (VC, VR) */
+static void check_view_run(int i, int j, int down, A2 a, void *base, 
+                           int count, void *cl)
+{
+        check_run_cells(i, j, down, a, base, count, VC, VR, cl);
+}
+
+/* checks a run of a row-major blocked array lies along a row */
+static void check_row_run(int i, int j, int down, A2 a, void *base, 
+                          int count, void *cl)
+{
+        assert(!down);
+        check_run(i, j, down, a, base, count, cl);
+}
+
+/* counts the cells of a run */
+static void count_run(void *base, int count, void *cl)
+{
+        (void)base;
+        *(int *)cl += count;
+}
+
+/* 
+ * checks the run maps visit every cell of the array and of a view once, 
+ * where at says, and for the blocked suite those of a copy of the array 
+ * whose blocks are in row-major order
+ */
+static void check_runs(A2 array)
+{
+        int counter = 0;
+        methods->map_runs(array, check_run, &counter);
+        assert(counter == W * H);
+        counter = 0;
+        methods->small_map_runs(array, count_run, &counter);
+        assert(counter == W * H);
+        if (methods->view) {
+                int w = W - VC - 4;
+                int h = H - VR - 2;
+                A2 view = methods->view(array, VC, VR, w, h);
+                counter = 0;
+                methods->map_runs(view, check_view_run, &counter);
+                assert(counter == w * h);
+                counter = 0;
+                methods->small_map_runs(view, count_run, &counter);
+                assert(counter == w * h);
+                methods->free(&view);
+        }
+        if (methods == uarray2_methods_blocked) {
+                A2 rows = UArray2b_new_tiled(W, H, sizeof(unsigned), 
+                                             blocksize, blocksize, 
+                                             UARRAY2B_ROW_MAJOR);
+                fill_test_values(methods, rows);
+                counter = 0;
+                methods->map_runs(rows, check_row_run, &counter);
+                assert(counter == W * H);
+                counter = 0;
+                methods->small_map_runs(rows, count_run, &counter);
+                assert(counter == W * H);
+                methods->free(&rows);
+        }
+}
+
+/* 
+ * follows a map over a two-level blocked array: the cells it has visited, 
+ * the micro-tile and block of the last one and the number of times each
+ * has changed, which is the number of micro-tiles and blocks when the map
+ * finishes each before starting the next
+ */
+struct tiling_walk {
+        int blocksize, microsize;
+        int micro, block;               /* -1 before the first cell */
+        int micros, blocks;
+        bool seen[W][H];
+};
+
+/* notes a visit to the cell (i, j), which must hold 1000 * i + j */
+static void walk_cell(struct tiling_walk *walk, int i, int j, unsigned *p)
+{
+        assert(i >= 0 && i < W && j >= 0 && j < H);
+        assert(*p == 1000u * i + j && !walk->seen[i][j]);
+        walk->seen[i][j] = true;
+        int micro = (j / walk->microsize) * W + i / walk->microsize;
+        int block = (j / walk->blocksize) * W + i / walk->blocksize;
+        walk->micros += micro != walk->micro;
+        walk->blocks += block != walk->block;
+        walk->micro = micro;
+        walk->block = block;
+}
+
+static void walk_map(int i, int j, A2 a, void *elem, void *cl)
+{
+        assert(elem == methods->at(a, i, j));
+        walk_cell(cl, i, j, elem);
+}
+
+/* small maps give no indices, so they are read back from the cell */
+static void walk_small_map(void *elem, void *cl)
+{
+        unsigned n = *(unsigned *)elem;
+        walk_cell(cl, n / 1000, n % 1000, elem);
+}
+
+/* 
+ * checks a tile of map_blocks is one whole (clipped) micro-tile whose 
+ * strides reach the cells at gives, with the cells next to each other along
+ * the rows or the columns as the array's order says
+ */
+static void walk_tile(A2 a, const A2Methods_Tile *tile, void *cl)
+{
+        struct tiling_walk *walk = cl;
+        int m = walk->microsize;
+        assert(tile->col % m == 0 && tile->row % m == 0);
+        assert(tile->width == (W - tile->col < m ? W - tile->col : m));
+        assert(tile->height == (H - tile->row < m ? H - tile->row : m));
+        int size = sizeof(unsigned);
+        if (UArray2b_order_of(a) == UARRAY2B_ROW_MAJOR) {
+                assert(tile->col_stride == size);
+                assert(tile->row_stride == m * size);
+        } else {
+                assert(tile->row_stride == size);
+                assert(tile->col_stride == m * size);
+        }
+        for (int i = 0; i < tile->width; i++) {
+                for (int j = 0; j < tile->height; j++) {
+                        assert((char *)tile->base + i * tile->col_stride 
+                                                  + j * tile->row_stride
+                               == methods->at(a, tile->col + i, 
+                                              tile->row + j));
+                }
+        }
+        int cells = 0;
+        check_tile(a, tile, &cells);
+        assert(cells == tile->width * tile->height);
+        walk->micros++;
+}
+
+/* 
+ * checks that each map the blocked suite has, and its tiles, visit every 
+ * cell of a two-level array once, finishing each micro-tile and each block
+ * before starting the next
+ */
+static void check_tiling(A2 array)
+{
+        int b = UArray2b_blocksize(array);
+        int m = UArray2b_microsize(array);
+        int micros = ((W + m - 1) / m) * ((H + m - 1) / m);
+        int blocks = ((W + b - 1) / b) * ((H + b - 1) / b);
+        A2Methods_mapfun *maps[] = { methods->map_default, 
+                                     methods->map_block_major };
+        A2Methods_smallmapfun *small_maps[] = { methods->small_map_default,
+                                               methods->small_map_block_major
+                                             };
+        for (int k = 0; k < 4; k++) {
+                struct tiling_walk walk = { b, m, -1, -1, 0, 0, { { 0 } } };
+                if (k < 2) {
+                        maps[k](array, walk_map, &walk);
+                } else {
+                        small_maps[k - 2](array, walk_small_map, &walk);
+                }
+                for (int i = 0; i < W; i++) {
+                        for (int j = 0; j < H; j++) {
+                                assert(walk.seen[i][j]);
+                        }
+                }
+                assert(walk.micros == micros && walk.blocks == blocks);
+        }
+        struct tiling_walk walk = { b, m, -1, -1, 0, 0, { { 0 } } };
+        methods->map_blocks(array, walk_tile, &walk);
+        assert(walk.micros == micros);
+        int counter = 0;
+        methods->map_runs(array, check_run, &counter);
+        assert(counter == W * H);
+        check_unchecked(array);
+        check_par_maps(array);
+}
+
+/* 
+ * checks UArray2b_new_two_level, and UArray2b_new_tiled in both orders, 
+ * with micro-tiles and blocks that do not divide the array and sides that 
+ * are and are not powers of two, and the arrays UArray2b_new_auto_block 
+ * makes under UArray2b_set_two_level
+ */
+static void check_two_level(void)
+{
+        methods = uarray2_methods_blocked;
+        int sizes[][2] = { { 6, 3 }, { 8, 2 }, { 8, 8 }, { 4, 1 } };
+        int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+        for (int s = 0; s < 3 * nsizes; s++) {
+                int b = sizes[s % nsizes][0];
+                int m = sizes[s % nsizes][1];
+                UArray2b_order order = s / nsizes == 2 ? UARRAY2B_ROW_MAJOR
+                                                       : UARRAY2B_COL_MAJOR;
+                A2 array = s < nsizes 
+                        ? UArray2b_new_two_level(W, H, sizeof(unsigned), b, m)
+                        : UArray2b_new_tiled(W, H, sizeof(unsigned), b, m, 
+                                             order);
+                assert(UArray2b_blocksize(array) == b);
+                assert(UArray2b_microsize(array) == m);
+                assert(UArray2b_order_of(array) == order);
+                fill_test_values(methods, array);
+                for (int i = 0; i < W; i++) {
+                        for (int j = 0; j < H; j++) {
+                                check(array, i, j, 1000u * i + j);
+                        }
+                }
+                check_tiling(array);
+                methods->free(&array);
+        }
+        for (int enabled = 0; enabled <= 1; enabled++) {
+                UArray2b_set_two_level(enabled);
+                UArray2b_set_order(enabled ? UARRAY2B_ROW_MAJOR 
+                                           : UARRAY2B_COL_MAJOR);
+                A2 array = methods->new(W, H, sizeof(unsigned));
+                int b = UArray2b_blocksize(array);
+                int m = UArray2b_microsize(array);
+                assert(m == (enabled ? UArray2b_auto_microsize(
+                                        sizeof(unsigned), b, NULL) : b));
+                assert(b % m == 0);
+                assert(UArray2b_order_of(array) == (enabled 
+                                                    ? UARRAY2B_ROW_MAJOR
+                                                    : UARRAY2B_COL_MAJOR));
+                methods->free(&array);
+        }
+        UArray2b_set_two_level(0);
+        UArray2b_set_order(UARRAY2B_COL_MAJOR);
+}
+
+/* 
+ * checks the test array survives conversion to every suite and back, whole
+ * and through a view, on one thread and on several
+ */
+static void check_convert(A2 array)
+{
+        A2Methods_T suites[] = { uarray2_methods_plain, 
+                                 uarray2_methods_blocked, 
+                                 uarray2_methods_morton };
+        int nsuites = sizeof(suites) / sizeof(suites[0]);
+        for (int threads = 1; threads <= 4; threads += 3) {
+                Parmap_set_threads(threads);
+                for (int k = 0; k < nsuites; k++) {
+                        A2 other = A2convert_new(suites[k], methods, array);
+                        A2 back = methods->new_with_blocksize(W, H, 
+                                                        sizeof(unsigned), 
+                                                        blocksize);
+                        A2convert_copy(methods, back, suites[k], other);
+                        for (int i = 0; i < W; i++) {
+                                for (int j = 0; j < H; j++) {
+                                        unsigned *p = suites[k]->at(other, 
+                                                                    i, j);
+                                        assert(*p == 1000u * i + j);
+                                        p = methods->at(back, i, j);
+                                        assert(*p == 1000u * i + j);
+                                }
+                        }
+                        methods->free(&back);
+                        suites[k]->free(&other);
+                }
+        }
+        if (methods->view) {
+                int w = W - VC - 4;
+                int h = H - VR - 2;
+                A2 view = methods->view(array, VC, VR, w, h);
+                A2 copy = A2convert_new(uarray2_methods_blocked, methods, 
+                                        view);
+                for (int i = 0; i < w; i++) {
+                        for (int j = 0; j < h; j++) {
+                                unsigned *p = UArray2b_at(copy, i, j);
+                                assert(*p == 1000u * (i + VC) + j + VR);
+                        }
+                }
+                uarray2_methods_blocked->free(&copy);
+                methods->free(&view);
+        }
+}
+
+/* the transformation kernels of kernels.h, specialized for unsigned cells */
+KERNEL_DEFINE_ALL(unsigned, unsigned)
+
+/* 
+ * checks dst, an array of suite, holds each cell (i, j) of the w x h window
+ * at (ci, cj) of an array filled by fill_test_values where Dihedral_apply 
+ * sends it under op
+ */
+static void check_moved(A2Methods_T suite, A2 dst, Dihedral_op op, int w, 
+                        int h, int ci, int cj)
+{
+        for (int i = 0; i < w; i++) {
+                for (int j = 0; j < h; j++) {
+                        int ti, tj;
+                        Dihedral_apply(op, w, h, i, j, &ti, &tj);
+                        unsigned *p = suite->at(dst, ti, tj);
+                        assert(*p == 1000u * (i + ci) + j + cj);
+                }
+        }
+}
+
+/* 
+ * checks the suite's transform and its kernels, plain and recursive (if it
+ * has them), send every cell where Dihedral_apply says, for each of the 
+ * eight ops, from the whole array and from a view of it
+ */
+static void check_transform(A2 array)
+{
+        A2 sources[2] = { array, NULL };
+        if (methods->view) {
+                sources[1] = methods->view(array, VC, VR, W - VC - 4, 
+                                           H - VR - 2);
+        }
+        for (int s = 0; s < 2 && sources[s] != NULL; s++) {
+                A2 src = sources[s];
+                int w = methods->width(src);
+                int h = methods->height(src);
+                int ci = s == 0 ? 0 : VC;
+                int cj = s == 0 ? 0 : VR;
+                for (int op = DIHEDRAL_IDENTITY; op <= DIHEDRAL_ANTITRANSPOSE;
+                     op++) {
+                        int swaps = Dihedral_swaps(op);
+                        int dw = swaps ? h : w;
+                        int dh = swaps ? w : h;
+                        if (methods->transform) {
+                                A2 dst = methods->new_with_blocksize(dw, dh, 
+                                                        sizeof(unsigned), 
+                                                        blocksize);
+                                methods->transform(src, dst, op);
+                                check_moved(methods, dst, op, w, h, ci, cj);
+                                methods->free(&dst);
+                        }
+                        Kernel_fun *kernels[] = { 
+                                unsigned_kernel(methods, op), 
+                                unsigned_recursive_kernel(methods, op) 
+                        };
+                        for (int k = 0; k < 2; k++) {
+                                if (kernels[k] == NULL) {
+                                        continue;
+                                }
+                                A2 dst = methods->new_with_blocksize(dw, dh, 
+                                                        sizeof(unsigned), 
+                                                        blocksize);
+                                kernels[k](src, dst);
+                                check_moved(methods, dst, op, w, h, ci, cj);
+                                methods->free(&dst);
+                        }
+                }
+        }
+        if (sources[1] != NULL) {
+                methods->free(&sources[1]);
+        }
+}
+
+/* 
+ * checks UArray2b_transform between two-level arrays of every pair of 
+ * orders, with micro-tiles of different sizes on the two sides, from the 
+ * whole source and from a view of it
+ */
+static void check_tiled_transform(void)
+{
+        methods = uarray2_methods_blocked;
+        UArray2b_order orders[] = { UARRAY2B_COL_MAJOR, UARRAY2B_ROW_MAJOR };
+        for (int o = 0; o < 4; o++) {
+                A2 src = UArray2b_new_tiled(W, H, sizeof(unsigned), 6, 3, 
+                                            orders[o / 2]);
+                fill_test_values(methods, src);
+                A2 view = methods->view(src, VC, VR, W - VC - 4, H - VR - 2);
+                for (int op = DIHEDRAL_IDENTITY; 
+                     op <= DIHEDRAL_ANTITRANSPOSE; op++) {
+                        for (int v = 0; v < 2; v++) {
+                                A2 from = v ? view : src;
+                                int w = methods->width(from);
+                                int h = methods->height(from);
+                                int swaps = Dihedral_swaps(op);
+                                A2 dst = UArray2b_new_tiled(swaps ? h : w, 
+                                                swaps ? w : h, 
+                                                sizeof(unsigned), 8, 2, 
+                                                orders[o % 2]);
+                                methods->transform(from, dst, op);
+                                check_moved(methods, dst, op, w, h, 
+                                            v ? VC : 0, v ? VR : 0);
+                                methods->free(&dst);
+                        }
+                }
+                methods->free(&view);
+                methods->free(&src);
+        }
+}
+
+/* 
+ * checks the suite's in place transform sends every cell where 
+ * Dihedral_apply says for each op it takes (those that keep the dimensions,
+ * and for the plain layout all eight), on a copy of the whole array and on
+ * a view of a copy, square for the ops that swap the dimensions, outside of
+ * which nothing may move
+ */
+static void check_in_place(A2 array)
+{
+        int plain = methods == uarray2_methods_plain;
+        for (int op = DIHEDRAL_IDENTITY; op <= DIHEDRAL_ANTITRANSPOSE; op++) {
+                if (Dihedral_swaps(op) && !plain) {
+                        continue;
+                }
+                A2 copy = A2convert_new(methods, methods, array);
+                methods->transform_in_place(copy, op);
+                check_moved(methods, copy, op, W, H, 0, 0);
+                methods->free(&copy);
+                if (methods->view == NULL) {
+                        continue;
+                }
+
+                copy = A2convert_new(methods, methods, array);
+                int w = W - VC - 4;
+                int h = Dihedral_swaps(op) ? w : H - VR - 2;
+                A2 window = methods->view(copy, VC, VR, w, h);
+                methods->transform_in_place(window, op);
+                check_moved(methods, window, op, w, h, VC, VR);
+                methods->free(&window);
+                for (int i = 0; i < W; i++) {
+                        for (int j = 0; j < H; j++) {
+                                unsigned *p = methods->at(copy, i, j);
+                                assert((i >= VC && i < VC + w && 
+                                        j >= VR && j < VR + h) 
+                                       || *p == 1000u * i + j);
+                        }
+                }
+                methods->free(&copy);
+        }
+}
+
+/* 
+ * checks that Dihedral_compose of every pair of ops sends every cell of a
+ * rectangle where doing the two ops one after the other does
+ */
+static void check_compose(void)
+{
+        int w = 5;
+        int h = 3;
+        for (int first = DIHEDRAL_IDENTITY; first <= DIHEDRAL_ANTITRANSPOSE;
+             first++) {
+                int mw = Dihedral_swaps(first) ? h : w;
+                int mh = Dihedral_swaps(first) ? w : h;
+                for (int second = DIHEDRAL_IDENTITY; 
+                     second <= DIHEDRAL_ANTITRANSPOSE; second++) {
+                        Dihedral_op op = Dihedral_compose(first, second);
+                        for (int i = 0; i < w; i++) {
+                                for (int j = 0; j < h; j++) {
+                                        int mi, mj, ti, tj, oi, oj;
+                                        Dihedral_apply(first, w, h, i, j, 
+                                                       &mi, &mj);
+                                        Dihedral_apply(second, mw, mh, mi, mj,
+                                                       &ti, &tj);
+                                        Dihedral_apply(op, w, h, i, j, 
+                                                       &oi, &oj);
+                                        assert(ti == oi && tj == oj);
+                                }
+                        }
+                }
+        }
+}
+
+/* 
+ * checks the recursive kernels on a plain array large enough for them to 
+ * split it several times before reaching their leaves
+ */
+static void check_recursive(void)
+{
+        A2Methods_T plain = uarray2_methods_plain;
+        int w = 61;
+        int h = 37;
+        A2 src = plain->new(w, h, sizeof(unsigned));
+        fill_test_values(plain, src);
+        for (int op = DIHEDRAL_IDENTITY; op <= DIHEDRAL_ANTITRANSPOSE; op++) {
+                int swaps = Dihedral_swaps(op);
+                A2 dst = plain->new(swaps ? h : w, swaps ? w : h, 
+                                    sizeof(unsigned));
+                unsigned_recursive_kernel(plain, op)(src, dst);
+                check_moved(plain, dst, op, w, h, 0, 0);
+                plain->free(&dst);
+        }
+        plain->free(&src);
+}
+
 static inline void copy_unsigned(A2Methods_T methods, A2 a,
                                  int i, int j, unsigned n) 
 {
@@ -120,9 +819,252 @@ static inline void copy_unsigned(A2Methods_T methods, A2 a,
         *p = n;
 }
 
-static void test_methods(A2Methods_T methods_under_test) 
+/*
+ * checks the kernels of the quarter turns and transposes of a suite on an
+ * array large enough to hold whole squares of cells
+ */
+static void check_square_kernels(A2Methods_T suite)
+{
+        int w = 53;
+        int h = 35;
+        A2 src = suite->new_with_blocksize(w, h, sizeof(unsigned), 16);
+        fill_test_values(suite, src);
+        Dihedral_op ops[] = { DIHEDRAL_ROTATE_90, DIHEDRAL_ROTATE_270, 
+                              DIHEDRAL_TRANSPOSE, DIHEDRAL_ANTITRANSPOSE };
+        for (int o = 0; o < 4; o++) {
+                A2 dst = suite->new_with_blocksize(h, w, sizeof(unsigned), 16);
+                unsigned_kernel(suite, ops[o])(src, dst);
+                check_moved(suite, dst, ops[o], w, h, 0, 0);
+                suite->free(&dst);
+        }
+        suite->free(&src);
+}
+
+/* 
+ * checks the in place transpose of plain arrays of many shapes, with and 
+ * without common factors in their dimensions and with padded rows, and of
+ * a wrapped buffer whose rows are not back to back
+ */
+static void check_transpose_in_place(void)
+{
+        methods = uarray2_methods_plain;
+        int shapes[][2] = { { 1, 1 }, { 1, 9 }, { 9, 1 }, { 2, 3 }, 
+                            { 6, 4 }, { 12, 18 }, { 17, 5 }, { 64, 3 }, 
+                            { 3, 64 }, { 64, 40 }, { 128, 96 }, { 30, 30 },
+                            { 100, 7 }, { 64, 128 } };
+        for (unsigned s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+                int w = shapes[s][0];
+                int h = shapes[s][1];
+                for (int op = DIHEDRAL_ROTATE_90; op <= DIHEDRAL_ANTITRANSPOSE;
+                     op++) {
+                        if (!Dihedral_swaps(op)) {
+                                continue;
+                        }
+                        A2 a = methods->new(w, h, sizeof(unsigned));
+                        fill_test_values(methods, a);
+                        methods->transform_in_place(a, op);
+                        assert(methods->width(a) == h);
+                        assert(methods->height(a) == w);
+                        check_moved(methods, a, op, w, h, 0, 0);
+                        methods->free(&a);
+                }
+        }
+
+        enum { WW = 7, WH = 5, WPITCH = 9 };
+        unsigned buffer[WH * WPITCH];
+        for (int i = 0; i < WW; i++) {
+                for (int j = 0; j < WH; j++) {
+                        buffer[j * WPITCH + i] = 1000u * i + j;
+                }
+        }
+        A2 wrapped = methods->wrap(buffer, WW, WH, sizeof(unsigned), 
+                                   WPITCH * sizeof(unsigned), NULL, NULL);
+        methods->transform_in_place(wrapped, DIHEDRAL_ROTATE_90);
+        check_moved(methods, wrapped, DIHEDRAL_ROTATE_90, WW, WH, 0, 0);
+        methods->free(&wrapped);
+}
+
+/*
+ * checks each vector tile transpose against its definition, and the 
+ * kernels that use them under each instruction set and for both orders of
+ * blocks
+ */
+static void check_simdtile(void)
+{
+        enum { CELLS = SIMDTILE_SIDE * 16 };
+        static char in_buf[SIMDTILE_SIDE][CELLS + 3];
+        static char out_buf[SIMDTILE_SIDE][CELLS + 5];
+        const char *in[SIMDTILE_SIDE];
+        char *out[SIMDTILE_SIDE];
+        for (int i = 0; i < SIMDTILE_SIDE; i++) {
+                for (int b = 0; b < CELLS; b++) {
+                        in_buf[i][b + 3] = (char)(31 * i + 7 * b);
+                }
+                in[i] = in_buf[i] + 3;     /* no alignment is assumed */
+                out[i] = out_buf[i] + 5;
+        }
+
+        A2Methods_T suites[] = { uarray2_methods_plain, 
+                                 uarray2_methods_blocked };
+        for (int isa = SIMDTILE_SCALAR; isa <= (int)Simdtile_best(); isa++) {
+                Simdtile_limit(isa);
+                int sizes[] = { 4, 8, 12, 16 };
+                for (int s = 0; s < 4; s++) {
+                        Simdtile_fun *transpose = Simdtile_transpose(sizes[s]);
+                        assert((transpose == NULL) == (isa == SIMDTILE_SCALAR));
+                        if (transpose == NULL) {
+                                continue;
+                        }
+                        transpose(out, in);
+                        for (int i = 0; i < SIMDTILE_SIDE; i++) {
+                                for (int k = 0; k < SIMDTILE_SIDE; k++) {
+                                        assert(memcmp(out[k] + i * sizes[s],
+                                                      in[i] + k * sizes[s],
+                                                      sizes[s]) == 0);
+                                }
+                        }
+                }
+                for (int m = 0; m < 3; m++) {
+                        UArray2b_set_order(m == 2 ? UARRAY2B_ROW_MAJOR 
+                                                  : UARRAY2B_COL_MAJOR);
+                        check_square_kernels(suites[m > 0]);
+                }
+        }
+        UArray2b_set_order(UARRAY2B_COL_MAJOR);
+        Simdtile_limit(SIMDTILE_AVX2);
+}
+
+/*
+ * checks Resample_rotate between every pair of suites, with and without
+ * the vector code: a quarter turn by either filter must move every pixel
+ * where the dihedral quarter turn does, and an eighth turn of one colour
+ * must fill the middle of its canvas with the colour and the corners with
+ * the background
+ */
+static void check_resample(void)
+{
+        A2Methods_T suites[] = { uarray2_methods_plain,
+                                 uarray2_methods_blocked,
+                                 uarray2_methods_morton };
+        int w = 70;
+        int h = 40;
+        struct Pnm_rgb background = { 7, 8, 9 };
+        for (int s = 0; s < 9; s++) {
+                A2Methods_T from = suites[s / 3];
+                A2Methods_T to = suites[s % 3];
+                Simdtile_limit(s % 2 == 0 ? SIMDTILE_AVX2 : SIMDTILE_SCALAR);
+                A2 src = from->new(w, h, sizeof(struct Pnm_rgb));
+                for (int i = 0; i < w; i++) {
+                        for (int j = 0; j < h; j++) {
+                                struct Pnm_rgb *px = from->at(src, i, j);
+                                *px = (struct Pnm_rgb){ i, j, i * j };
+                        }
+                }
+                int rw, rh;
+                Resample_rotated_size(w, h, 90, &rw, &rh);
+                assert(rw == h && rh == w);
+                A2 dst = to->new(rw, rh, sizeof(struct Pnm_rgb));
+                for (int f = RESAMPLE_NEAREST; f <= RESAMPLE_BILINEAR; f++) {
+                        Resample_rotate(to, dst, from, src, 90, f,
+                                        &background);
+                        for (int i = 0; i < w; i++) {
+                                for (int j = 0; j < h; j++) {
+                                        int ni, nj;
+                                        Dihedral_apply(DIHEDRAL_ROTATE_90, w,
+                                                       h, i, j, &ni, &nj);
+                                        struct Pnm_rgb *px = to->at(dst, ni,
+                                                                    nj);
+                                        assert(px->red == (unsigned)i &&
+                                               px->green == (unsigned)j &&
+                                               px->blue == (unsigned)(i * j));
+                                }
+                        }
+                }
+                to->free(&dst);
+
+                for (int i = 0; i < w; i++) {
+                        for (int j = 0; j < h; j++) {
+                                struct Pnm_rgb *px = from->at(src, i, j);
+                                *px = (struct Pnm_rgb){ 100, 150, 200 };
+                        }
+                }
+                Resample_rotated_size(w, h, 45, &rw, &rh);
+                assert(rw == 78 && rh == 78);   /* 110 / sqrt(2) */
+                dst = to->new(rw, rh, sizeof(struct Pnm_rgb));
+                Resample_rotate(to, dst, from, src, 45, RESAMPLE_BILINEAR,
+                                &background);
+                struct Pnm_rgb *middle = to->at(dst, rw / 2, rh / 2);
+                struct Pnm_rgb *corner = to->at(dst, rw - 1, 0);
+                assert(middle->red == 100 && middle->green == 150 &&
+                       middle->blue == 200);
+                assert(corner->red == 7 && corner->green == 8 &&
+                       corner->blue == 9);
+                to->free(&dst);
+                from->free(&src);
+        }
+        Simdtile_limit(SIMDTILE_AVX2);
+}
+
+/*
+ * checks Resample_scale between every pair of suites, with and without
+ * the vector code: scaling to the same size must leave every pixel as it
+ * was whatever the filter, and halving both sides with the box filter
+ * must average each 2 x 2 square
+ */
+static void check_scale(void)
+{
+        A2Methods_T suites[] = { uarray2_methods_plain,
+                                 uarray2_methods_blocked,
+                                 uarray2_methods_morton };
+        int w = 70;
+        int h = 44;
+        for (int s = 0; s < 9; s++) {
+                A2Methods_T from = suites[s / 3];
+                A2Methods_T to = suites[s % 3];
+                Simdtile_limit(s % 2 == 0 ? SIMDTILE_AVX2 : SIMDTILE_SCALAR);
+                A2 src = from->new(w, h, sizeof(struct Pnm_rgb));
+                for (int i = 0; i < w; i++) {
+                        for (int j = 0; j < h; j++) {
+                                struct Pnm_rgb *px = from->at(src, i, j);
+                                *px = (struct Pnm_rgb){ 2 * i, 2 * j, 7 };
+                        }
+                }
+                A2 same = to->new(w, h, sizeof(struct Pnm_rgb));
+                for (int f = RESAMPLE_NEAREST; f <= RESAMPLE_LANCZOS; f++) {
+                        Resample_scale(to, same, from, src, f, 255);
+                        for (int i = 0; i < w; i++) {
+                                for (int j = 0; j < h; j++) {
+                                        struct Pnm_rgb *px = to->at(same, i,
+                                                                    j);
+                                        assert(px->red == 2u * i &&
+                                               px->green == 2u * j &&
+                                               px->blue == 7);
+                                }
+                        }
+                }
+                to->free(&same);
+
+                A2 half = to->new(w / 2, h / 2, sizeof(struct Pnm_rgb));
+                Resample_scale(to, half, from, src, RESAMPLE_BOX, 255);
+                for (int i = 0; i < w / 2; i++) {
+                        for (int j = 0; j < h / 2; j++) {
+                                struct Pnm_rgb *px = to->at(half, i, j);
+                                assert(px->red == 4u * i + 1 &&
+                                       px->green == 4u * j + 1 &&
+                                       px->blue == 7);
+                        }
+                }
+                to->free(&half);
+                from->free(&src);
+        }
+        Simdtile_limit(SIMDTILE_AVX2);
+}
+
+static void test_methods(A2Methods_T methods_under_test, 
+                         int blocksize_under_test) 
 {
         methods = methods_under_test;
+        blocksize = blocksize_under_test;
         assert(methods);
         assert(has_minimum_methods(methods));
         assert(has_small_plain_methods(methods)
@@ -135,7 +1077,8 @@ static void test_methods(A2Methods_T methods_under_test)
         if (!(has_plain_methods(methods) || has_blocked_methods(methods)))
                 fprintf(stderr, "Some full mapping methods are missing\n");
 
-        A2 array = methods->new_with_blocksize(W, H, sizeof(unsigned), BS);
+        A2 array = methods->new_with_blocksize(W, H, sizeof(unsigned), 
+                                               blocksize);
         copy_unsigned(methods, array,  2,  1, 99);
         copy_unsigned(methods, array,  3,  3, 88);
         copy_unsigned(methods, array, 10, 10, 77);
@@ -157,6 +1100,35 @@ static void test_methods(A2Methods_T methods_under_test)
                         assert(*p == n);
                 }
         }
+        if (methods->map_blocks) {
+                int counter = 0;
+                methods->map_blocks(array, check_tile, &counter);
+                assert(counter == W * H);
+        }
+        if (methods == uarray2_methods_plain 
+            || methods == uarray2_methods_blocked) {
+                check_unchecked(array);
+        }
+        if (methods->row_span && methods->col_span) {
+                check_spans(array);
+        }
+        if (methods->view) {
+                check_view(array);
+        }
+        if (methods->wrap) {
+                check_wrap();
+        }
+        check_par_maps(array);
+        if (methods->map_runs && methods->small_map_runs) {
+                check_runs(array);
+        }
+        check_convert(array);
+        if (methods->transform) {
+                check_transform(array);
+        }
+        if (methods->transform_in_place) {
+                check_in_place(array);
+        }
         double_row_major_plus();
         methods->free(&array);
 }
@@ -165,8 +1137,18 @@ int main(int argc, char *argv[])
 {
         assert(argc == 1);
         (void)argv;
-        test_methods(uarray2_methods_plain);
-        test_methods(uarray2_methods_blocked);
+        test_methods(uarray2_methods_plain, BS);
+        test_methods(uarray2_methods_blocked, BS);
+        test_methods(uarray2_methods_blocked, ODD_BS);
+        test_methods(uarray2_methods_morton, BS);
+        check_two_level();
+        check_tiled_transform();
+        check_compose();
+        check_recursive();
+        check_simdtile();
+        check_transpose_in_place();
+        check_resample();
+        check_scale();
         printf("Passed.\n");  /* only if we reach this point without
                                * assertion failure
                                */
@@ -0,0 +1,142 @@
+/*
+ *     cacheinfo.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of data cache hierarchy discovery. Sizes are
+ *              read once, from sysfs when it is available and from sysconf
+ *              otherwise, and remembered for the life of the program.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <assert.h>
+#include "cacheinfo.h"
+
+#define MAX_LEVEL 3
+#define MAX_INDEX 16
+#define SYSFS_CACHE "/sys/devices/system/cpu/cpu0/cache"
+
+static long cache_sizes[MAX_LEVEL + 1];
+static bool loaded = false;
+
+/**********read_line********
+ *
+ * Reads the first line of the file at path into buf, without its newline.
+ * Returns true on success and false if the file cannot be read.
+ ************************/
+static bool read_line(const char *path, char *buf, int len)
+{
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+                return false;
+        }
+        bool ok = fgets(buf, len, fp) != NULL;
+        fclose(fp);
+        if (ok) {
+                buf[strcspn(buf, "\n")] = '\0';
+        }
+        return ok;
+}
+
+/**********parse_size********
+ *
+ * Converts a sysfs cache size such as "32K" or "16M" to bytes, returning 0
+ * if it cannot be parsed
+ ************************/
+static long parse_size(const char *text)
+{
+        char *end;
+        long n = strtol(text, &end, 10);
+        if (end == text || n < 0) {
+                return 0;
+        }
+        if (*end == 'K') {
+                n *= 1024;
+        } else if (*end == 'M') {
+                n *= 1024 * 1024;
+        } else if (*end == 'G') {
+                n *= 1024L * 1024 * 1024;
+        }
+        return n;
+}
+
+/**********load_sysfs********
+ *
+ * Fills cache_sizes from the cache descriptions in sysfs. Instruction caches
+ * are skipped; data and unified caches are recorded by level.
+ ************************/
+static void load_sysfs(void)
+{
+        char path[128];
+        char buf[64];
+        for (int i = 0; i < MAX_INDEX; i++) {
+                snprintf(path, sizeof(path), SYSFS_CACHE "/index%d/type", i);
+                if (!read_line(path, buf, sizeof(buf))) {
+                        break;
+                }
+                if (strcmp(buf, "Instruction") == 0) {
+                        continue;
+                }
+                snprintf(path, sizeof(path), SYSFS_CACHE "/index%d/level", i);
+                if (!read_line(path, buf, sizeof(buf))) {
+                        continue;
+                }
+                int level = atoi(buf);
+                if (level < 1 || level > MAX_LEVEL) {
+                        continue;
+                }
+                snprintf(path, sizeof(path), SYSFS_CACHE "/index%d/size", i);
+                if (read_line(path, buf, sizeof(buf))) {
+                        cache_sizes[level] = parse_size(buf);
+                }
+        }
+}
+
+/**********load_sysconf********
+ *
+ * Fills any level of cache_sizes that sysfs did not provide from sysconf,
+ * where the C library supports it
+ ************************/
+static void load_sysconf(void)
+{
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+        long from_sysconf[MAX_LEVEL + 1] = {
+                0,
+                sysconf(_SC_LEVEL1_DCACHE_SIZE),
+                sysconf(_SC_LEVEL2_CACHE_SIZE),
+                sysconf(_SC_LEVEL3_CACHE_SIZE),
+        };
+        for (int level = 1; level <= MAX_LEVEL; level++) {
+                if (cache_sizes[level] <= 0 && from_sysconf[level] > 0) {
+                        cache_sizes[level] = from_sysconf[level];
+                }
+        }
+#endif
+}
+
+/**********Cacheinfo_size********
+ *
+ * Returns the size, in bytes, of the data or unified cache at the given level
+ * Inputs:
+ *              int level: the cache level, from 1 (closest to the core) to 3
+ * Return: the size of that cache in bytes, or 0 if it is not known
+ * Expects:
+ *      level to be between 1 and 3
+ * Notes:
+ *      Checked runtime error if level is out of range
+ *      The hierarchy is discovered on the first call only
+ ************************/
+long Cacheinfo_size(int level)
+{
+        assert(level >= 1 && level <= MAX_LEVEL);
+        if (!loaded) {
+                load_sysfs();
+                load_sysconf();
+                loaded = true;
+        }
+        return cache_sizes[level] > 0 ? cache_sizes[level] : 0;
+}
@@ -0,0 +1,21 @@
+/*
+ *     cacheinfo.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for discovering the data cache hierarchy of the
+ *              machine the program is running on
+ */
+
+#ifndef CACHEINFO_INCLUDED
+#define CACHEINFO_INCLUDED
+
+/* 
+ * Returns the size in bytes of the data (or unified) cache at the given 
+ * level (1, 2 or 3) of the first CPU, or 0 if the size cannot be found. 
+ * The hierarchy is read from /sys/devices/system/cpu/cpu0/cache the first 
+ * time it is needed, falling back to sysconf.
+ */
+extern long Cacheinfo_size(int level);
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ *     dihedral.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: The eight symmetries of a rectangle (the rotations by
+ *              multiples of 90 degrees and the four reflections) and the
+ *              coordinate arithmetic the layouts use to move a cell to its
+ *              place in the transformed image
+ */
+
+#ifndef DIHEDRAL_INCLUDED
+#define DIHEDRAL_INCLUDED
+
+/*
+ * Where an op sends the cell at (col, row) of a width x height image:
+ *      DIHEDRAL_IDENTITY           (col, row)
+ *      DIHEDRAL_ROTATE_90          (height - row - 1, col)      clockwise
+ *      DIHEDRAL_ROTATE_180         (width - col - 1, height - row - 1)
+ *      DIHEDRAL_ROTATE_270         (row, width - col - 1)
+ *      DIHEDRAL_FLIP_HORIZONTAL    (width - col - 1, row)
+ *      DIHEDRAL_FLIP_VERTICAL      (col, height - row - 1)
+ *      DIHEDRAL_TRANSPOSE          (row, col)
+ *      DIHEDRAL_ANTITRANSPOSE      (height - row - 1, width - col - 1)
+ * ROTATE_90, ROTATE_270, TRANSPOSE and ANTITRANSPOSE swap the width and
+ * the height of the image.
+ */
+typedef enum {
+        DIHEDRAL_IDENTITY,
+        DIHEDRAL_ROTATE_90,
+        DIHEDRAL_ROTATE_180,
+        DIHEDRAL_ROTATE_270,
+        DIHEDRAL_FLIP_HORIZONTAL,
+        DIHEDRAL_FLIP_VERTICAL,
+        DIHEDRAL_TRANSPOSE,
+        DIHEDRAL_ANTITRANSPOSE
+} Dihedral_op;
+
+/**********Dihedral_swaps********
+ *
+ * Returns 1 if op turns a width x height image into a height x width one,
+ * 0 if the transformed image has the original's dimensions
+ ************************/
+static inline int Dihedral_swaps(Dihedral_op op)
+{
+        return op == DIHEDRAL_ROTATE_90 || op == DIHEDRAL_ROTATE_270 ||
+               op == DIHEDRAL_TRANSPOSE || op == DIHEDRAL_ANTITRANSPOSE;
+}
+
+/**********Dihedral_inverse********
+ *
+ * Returns the op that undoes op. Only the quarter turns are not their own
+ * inverses.
+ ************************/
+static inline Dihedral_op Dihedral_inverse(Dihedral_op op)
+{
+        if (op == DIHEDRAL_ROTATE_90) {
+                return DIHEDRAL_ROTATE_270;
+        } else if (op == DIHEDRAL_ROTATE_270) {
+                return DIHEDRAL_ROTATE_90;
+        }
+        return op;
+}
+
+/**********Dihedral_apply********
+ *
+ * Finds where op sends a cell
+ * Inputs:
+ *              Dihedral_op op: the transformation
+ *              int width, int height: the dimensions of the image before the
+ *                      transformation
+ *              int col, int row: a cell of that image
+ *              int *to_col, int *to_row: set to the cell of the transformed
+ *                      image that (col, row) becomes
+ * Return: N/A
+ * Expects:
+ *      0 <= col < width and 0 <= row < height
+ * Notes:
+ *      The cell of the original image that lands on (col, row) of the
+ *      transformed image is found by applying Dihedral_inverse(op) with the
+ *      transformed image's dimensions
+ ************************/
+static inline void Dihedral_apply(Dihedral_op op, int width, int height,
+                                  int col, int row, int *to_col, int *to_row)
+{
+        switch (op) {
+        case DIHEDRAL_ROTATE_90:
+                *to_col = height - row - 1;
+                *to_row = col;
+                break;
+        case DIHEDRAL_ROTATE_180:
+                *to_col = width - col - 1;
+                *to_row = height - row - 1;
+                break;
+        case DIHEDRAL_ROTATE_270:
+                *to_col = row;
+                *to_row = width - col - 1;
+                break;
+        case DIHEDRAL_FLIP_HORIZONTAL:
+                *to_col = width - col - 1;
+                *to_row = row;
+                break;
+        case DIHEDRAL_FLIP_VERTICAL:
+                *to_col = col;
+                *to_row = height - row - 1;
+                break;
+        case DIHEDRAL_TRANSPOSE:
+                *to_col = row;
+                *to_row = col;
+                break;
+        case DIHEDRAL_ANTITRANSPOSE:
+                *to_col = height - row - 1;
+                *to_row = width - col - 1;
+                break;
+        case DIHEDRAL_IDENTITY:
+        default:
+                *to_col = col;
+                *to_row = row;
+                break;
+        }
+}
+
+/*
+ * Every op is affine: it sends (col, row) to
+ *      (col0 + col * dcol_col + row * dcol_row,
+ *       row0 + col * drow_col + row * drow_row)
+ * so a loop can step through the transformed positions of a line of cells
+ * by adding constants instead of working out each one.
+ */
+typedef struct Dihedral_steps {
+        int col0, row0;                 // where (0, 0) goes
+        int dcol_col, drow_col;         // change for one step right
+        int dcol_row, drow_row;         // change for one step down
+} Dihedral_steps;
+
+/**********Dihedral_steps_of********
+ *
+ * Returns the affine form (see Dihedral_steps) of op on a width x height
+ * image. The arithmetic of Dihedral_apply holds outside the image too, so
+ * images one cell wide or high need no special case.
+ ************************/
+static inline Dihedral_steps Dihedral_steps_of(Dihedral_op op, int width,
+                                               int height)
+{
+        Dihedral_steps steps;
+        int c, r;
+        Dihedral_apply(op, width, height, 0, 0, &steps.col0, &steps.row0);
+        Dihedral_apply(op, width, height, 1, 0, &c, &r);
+        steps.dcol_col = c - steps.col0;
+        steps.drow_col = r - steps.row0;
+        Dihedral_apply(op, width, height, 0, 1, &c, &r);
+        steps.dcol_row = c - steps.col0;
+        steps.drow_row = r - steps.row0;
+        return steps;
+}
+
+/**********Dihedral_compose********
+ *
+ * Returns the op that does first and then second, so a chain of 
+ * transformations can be carried out in one pass
+ * Inputs:
+ *              Dihedral_op first: the transformation done first
+ *              Dihedral_op second: the transformation done to its result
+ * Return: the single op with the same effect as the two
+ * Notes:
+ *      The symmetries of a rectangle form a group of eight elements, so
+ *      the composition is always one of them. An affine map is fixed by 
+ *      where it sends (0, 0), (1, 0) and (0, 1), so the op is found by 
+ *      following those three cells of a 2 x 3 rectangle (which is not 
+ *      square, so ops that differ only in swapping the dimensions are told
+ *      apart) through first and second and checking each op against them.
+ ************************/
+static inline Dihedral_op Dihedral_compose(Dihedral_op first, 
+                                           Dihedral_op second)
+{
+        static const int cells[3][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 } };
+        int width = 2;
+        int height = 3;
+        int mid_width = Dihedral_swaps(first) ? height : width;
+        int mid_height = Dihedral_swaps(first) ? width : height;
+        int op;
+        for (op = DIHEDRAL_IDENTITY; op < DIHEDRAL_ANTITRANSPOSE; op++) {
+                int k;
+                for (k = 0; k < 3; k++) {
+                        int mid_col, mid_row, col, row, op_col, op_row;
+                        Dihedral_apply(first, width, height, cells[k][0], 
+                                       cells[k][1], &mid_col, &mid_row);
+                        Dihedral_apply(second, mid_width, mid_height, 
+                                       mid_col, mid_row, &col, &row);
+                        Dihedral_apply((Dihedral_op)op, width, height, 
+                                       cells[k][0], cells[k][1], &op_col, 
+                                       &op_row);
+                        if (col != op_col || row != op_row) {
+                                break;
+                        }
+                }
+                if (k == 3) {
+                        break;
+                }
+        }
+        return (Dihedral_op)op;   /* the last op, if no other matched */
+}
+
+#endif
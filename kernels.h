@@ -0,0 +1,481 @@
+/*
+ *     kernels.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Macros that generate a transformation kernel for each of the
+ *              eight symmetries of a rectangle (see dihedral.h) and each
+ *              layout whose representation is exposed (UArray2 and
+ *              UArray2b), plus a cache-oblivious recursive kernel for each
+ *              symmetry on UArray2. The cell type and the coordinate 
+ *              arithmetic of a kernel are fixed when it is compiled, so it
+ *              copies pixels with plain assignments and makes no call per 
+ *              pixel. The tiled kernels of the quarter turns and transposes
+ *              hand whole squares of cells to the vector transposes of
+ *              simdtile.h when the machine has them.
+ */
+
+#ifndef KERNELS_INCLUDED
+#define KERNELS_INCLUDED
+
+#include <assert.h>
+#include <stddef.h>
+#include "dihedral.h"
+#include "simdtile.h"
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "uarray2.h"
+#include "uarray2_impl.h"
+#include "uarray2b.h"
+#include "uarray2b_impl.h"
+
+/*
+ * copies every cell of src to its place in dst under the kernel's op; src
+ * and dst are arrays of the kernel's layout with the kernel's cell size
+ */
+typedef void Kernel_fun(A2Methods_UArray2 src, A2Methods_UArray2 dst);
+
+/*
+ * side, in cells, of the square tiles the plain kernels of the quarter
+ * turns and transposes walk: a tile's column of source cells touches
+ * KERNEL_TILE cache lines, which stay in the L1 cache for the whole tile
+ */
+#define KERNEL_TILE 32
+
+/*
+ * The source cell that lands on (c, r) of the destination, for a source of
+ * sw x sh cells (the inverse of each op in dihedral.h), and whether the op
+ * swaps the dimensions
+ */
+#define KERNEL_IDENTITY_COL             (c)
+#define KERNEL_IDENTITY_ROW             (r)
+#define KERNEL_IDENTITY_SWAPS           0
+#define KERNEL_ROTATE_90_COL            (r)
+#define KERNEL_ROTATE_90_ROW            (sh - c - 1)
+#define KERNEL_ROTATE_90_SWAPS          1
+#define KERNEL_ROTATE_180_COL           (sw - c - 1)
+#define KERNEL_ROTATE_180_ROW           (sh - r - 1)
+#define KERNEL_ROTATE_180_SWAPS         0
+#define KERNEL_ROTATE_270_COL           (sw - r - 1)
+#define KERNEL_ROTATE_270_ROW           (c)
+#define KERNEL_ROTATE_270_SWAPS         1
+#define KERNEL_FLIP_HORIZONTAL_COL      (sw - c - 1)
+#define KERNEL_FLIP_HORIZONTAL_ROW      (r)
+#define KERNEL_FLIP_HORIZONTAL_SWAPS    0
+#define KERNEL_FLIP_VERTICAL_COL        (c)
+#define KERNEL_FLIP_VERTICAL_ROW        (sh - r - 1)
+#define KERNEL_FLIP_VERTICAL_SWAPS      0
+#define KERNEL_TRANSPOSE_COL            (r)
+#define KERNEL_TRANSPOSE_ROW            (c)
+#define KERNEL_TRANSPOSE_SWAPS          1
+#define KERNEL_ANTITRANSPOSE_COL        (sw - r - 1)
+#define KERNEL_ANTITRANSPOSE_ROW        (sh - c - 1)
+#define KERNEL_ANTITRANSPOSE_SWAPS      1
+
+/**********KERNEL_SQUARE********
+ *
+ * Defines NAME_square, which fills a SIMDTILE_SIDE x SIMDTILE_SIDE square
+ * of the destination with one vector transpose from simdtile.h. The lines
+ * of the square are contiguous, the k-th starting at out + k * across 
+ * bytes, and the first line starts at the destination cell (c, r). 
+ * NAME_src(src, c, r), defined by the kernel, locates the source cell of a
+ * destination cell. Over the square, the source address must change by 
+ * along bytes from one cell of a line to the next and by next bytes from
+ * one line to the next, and next must be plus or minus the cell size: the
+ * source cells that land on one position of every line are contiguous.
+ ************************/
+#define KERNEL_SQUARE(NAME, SRC_T)                                            \
+static inline void NAME##_square(SRC_T src, char *out, ptrdiff_t across,     \
+                                 int c, int r, ptrdiff_t along,               \
+                                 ptrdiff_t next, Simdtile_fun *transpose)     \
+{                                                                             \
+        const int last = SIMDTILE_SIDE - 1;                                   \
+        const char *in_lines[SIMDTILE_SIDE];                                  \
+        char *out_lines[SIMDTILE_SIDE];                                       \
+        const char *first = NAME##_src(src, c, r);                            \
+        int up = next < 0;      /* source cells run against the lines */      \
+        if (up) {                                                             \
+                first += last * next;                                         \
+        }                                                                     \
+        for (int i = 0; i < SIMDTILE_SIDE; i++) {                             \
+                in_lines[i] = first + i * along;                              \
+                out_lines[i] = out + (up ? last - i : i) * across;            \
+        }                                                                     \
+        transpose(out_lines, in_lines);                                       \
+}
+
+/**********KERNEL_PLAIN********
+ *
+ * Defines static Kernel_fun NAME for UArray2s of CELLs under OP (one of the
+ * suffixes above, such as ROTATE_90), along with NAME_rect, which fills 
+ * the columns [c0, c1) of the rows [r0, r1) of the destination row by row,
+ * each cell gathered from the source. The ops that swap the dimensions 
+ * read the source down its columns, so NAME walks the destination in 
+ * KERNEL_TILE x KERNEL_TILE tiles to reuse the source lines they touch,
+ * and fills each tile with vector transposes (see KERNEL_SQUARE) when
+ * there are any for CELL, leaving only its ragged edges to NAME_rect.
+ ************************/
+#define KERNEL_PLAIN(NAME, CELL, OP)                                          \
+static inline const char *NAME##_src(UArray2_T src, int c, int r)            \
+{                                                                             \
+        int sw = src->width;                                                  \
+        int sh = src->height;                                                 \
+        (void)sw;                                                             \
+        (void)sh;                                                             \
+        return src->elems + (size_t)KERNEL_##OP##_ROW * src->pitch +          \
+               (size_t)KERNEL_##OP##_COL * sizeof(CELL);                      \
+}                                                                             \
+KERNEL_SQUARE(NAME, UArray2_T)                                                \
+static inline void NAME##_rect(UArray2_T src, UArray2_T dst, int c0, int r0, \
+                               int c1, int r1)                                \
+{                                                                             \
+        int sw = src->width;                                                  \
+        int sh = src->height;                                                 \
+        (void)sw;                                                             \
+        (void)sh;                                                             \
+        for (int r = r0; r < r1; r++) {                                       \
+                CELL *out = (CELL *)(dst->elems + (size_t)r * dst->pitch);    \
+                for (int c = c0; c < c1; c++) {                               \
+                        out[c] = *(const CELL *)(src->elems +                 \
+                                (size_t)KERNEL_##OP##_ROW * src->pitch +      \
+                                (size_t)KERNEL_##OP##_COL * sizeof(CELL));    \
+                }                                                             \
+        }                                                                     \
+}                                                                             \
+static inline void NAME##_simd(UArray2_T src, UArray2_T dst, int c0, int r0, \
+                               int c1, int r1, Simdtile_fun *transpose)       \
+{                                                                             \
+        if (c1 - c0 < SIMDTILE_SIDE || r1 - r0 < SIMDTILE_SIDE) {             \
+                NAME##_rect(src, dst, c0, r0, c1, r1);                        \
+                return;                                                       \
+        }                                                                     \
+        const char *at = NAME##_src(src, 0, 0);                               \
+        ptrdiff_t along = NAME##_src(src, 1, 0) - at;                         \
+        ptrdiff_t next = NAME##_src(src, 0, 1) - at;                          \
+        int r = r0;                                                           \
+        for (; r + SIMDTILE_SIDE <= r1; r += SIMDTILE_SIDE) {                 \
+                int c = c0;                                                   \
+                for (; c + SIMDTILE_SIDE <= c1; c += SIMDTILE_SIDE) {         \
+                        NAME##_square(src, dst->elems +                       \
+                                      (size_t)r * dst->pitch +                \
+                                      (size_t)c * sizeof(CELL), dst->pitch,   \
+                                      c, r, along, next, transpose);          \
+                }                                                             \
+                NAME##_rect(src, dst, c, r, c1, r + SIMDTILE_SIDE);           \
+        }                                                                     \
+        NAME##_rect(src, dst, c0, r, c1, r1);                                 \
+}                                                                             \
+static void NAME(A2Methods_UArray2 vsrc, A2Methods_UArray2 vdst)             \
+{                                                                             \
+        UArray2_T src = vsrc;                                                 \
+        UArray2_T dst = vdst;                                                 \
+        assert((size_t)src->size == sizeof(CELL) &&                           \
+               (size_t)dst->size == sizeof(CELL));                            \
+        Simdtile_fun *transpose = KERNEL_##OP##_SWAPS ?                       \
+                                  Simdtile_transpose(sizeof(CELL)) : NULL;    \
+        int tile_w = KERNEL_##OP##_SWAPS ? KERNEL_TILE : dst->width;          \
+        int tile_h = KERNEL_##OP##_SWAPS ? KERNEL_TILE : dst->height;         \
+        for (int r0 = 0; r0 < dst->height; r0 += tile_h) {                    \
+                int r1 = r0 + tile_h < dst->height ? r0 + tile_h              \
+                                                   : dst->height;             \
+                for (int c0 = 0; c0 < dst->width; c0 += tile_w) {             \
+                        int c1 = c0 + tile_w < dst->width ? c0 + tile_w       \
+                                                          : dst->width;       \
+                        if (transpose != NULL) {                              \
+                                NAME##_simd(src, dst, c0, r0, c1, r1,         \
+                                            transpose);                       \
+                        } else {                                              \
+                                NAME##_rect(src, dst, c0, r0, c1, r1);        \
+                        }                                                     \
+                }                                                             \
+        }                                                                     \
+}
+
+/*
+ * the most cells in a leaf of the recursive kernels: a leaf and the source
+ * cells it reads (6KB for 12-byte cells) fit in the L1 cache of any 
+ * machine, so the recursion needs no tuning to the one it runs on
+ */
+#define KERNEL_LEAF_CELLS 256
+
+/**********KERNEL_RECURSIVE********
+ *
+ * Defines static Kernel_fun NAME for UArray2s of CELLs under OP, a 
+ * cache-oblivious divide and conquer over the destination: a rectangle is 
+ * halved across its longer side until it holds at most KERNEL_LEAF_CELLS 
+ * cells, and each leaf is filled by RECT (the NAME_rect of the plain 
+ * kernel for OP). Every level of the recursion keeps the rectangles it 
+ * reads and writes close to square, so whichever cache level a rectangle 
+ * first fits in, its source and destination lines stay there while it is
+ * copied.
+ ************************/
+#define KERNEL_RECURSIVE(NAME, CELL, RECT)                                    \
+static void NAME##_split(UArray2_T src, UArray2_T dst, int c0, int r0,       \
+                         int c1, int r1)                                      \
+{                                                                             \
+        int w = c1 - c0;                                                      \
+        int h = r1 - r0;                                                      \
+        if ((long)w * h <= KERNEL_LEAF_CELLS) {                               \
+                RECT(src, dst, c0, r0, c1, r1);                               \
+        } else if (w >= h) {                                                  \
+                NAME##_split(src, dst, c0, r0, c0 + w / 2, r1);               \
+                NAME##_split(src, dst, c0 + w / 2, r0, c1, r1);               \
+        } else {                                                              \
+                NAME##_split(src, dst, c0, r0, c1, r0 + h / 2);               \
+                NAME##_split(src, dst, c0, r0 + h / 2, c1, r1);               \
+        }                                                                     \
+}                                                                             \
+static void NAME(A2Methods_UArray2 vsrc, A2Methods_UArray2 vdst)             \
+{                                                                             \
+        UArray2_T src = vsrc;                                                 \
+        UArray2_T dst = vdst;                                                 \
+        assert((size_t)src->size == sizeof(CELL) &&                           \
+               (size_t)dst->size == sizeof(CELL));                            \
+        NAME##_split(src, dst, 0, 0, dst->width, dst->height);                \
+}
+
+/*
+ * nonzero if the cells (c0, r0) and (c1, r1) of a UArray2b lie in the same
+ * micro-tile
+ */
+static inline int Kernel_same_micro(UArray2b_T array2b, int c0, int r0, 
+                                    int c1, int r1)
+{
+        c0 += array2b->col0;
+        r0 += array2b->row0;
+        c1 += array2b->col0;
+        r1 += array2b->row0;
+        int shift = array2b->log_microsize;
+        if (shift >= 0) {
+                return (c0 >> shift) == (c1 >> shift) && 
+                       (r0 >> shift) == (r1 >> shift);
+        }
+        int micro = array2b->microsize;
+        return c0 / micro == c1 / micro && r0 / micro == r1 / micro;
+}
+
+/* 
+ * the closure of a blocked kernel's tile function: the source array and
+ * the vector transpose for the kernel's cells, or NULL to copy cell by cell
+ */
+struct Kernel_blocked {
+        UArray2b_T src;
+        Simdtile_fun *transpose;
+};
+
+/**********KERNEL_BLOCKED********
+ *
+ * Defines static Kernel_fun NAME for UArray2bs of CELLs under OP. The
+ * destination is filled one block (or micro-tile) at a time in storage
+ * order through UArray2b_map_blocks, so the only indirect call is one per
+ * tile. Each contiguous line of a destination tile is gathered from a row
+ * or column of the source; the source cell is located with the inline 
+ * unchecked accessor only where the line enters a source micro-tile, and 
+ * is stepped by a constant stride inside it. For the ops that swap the
+ * dimensions, the lines of a tile are taken SIMDTILE_SIDE at a time and
+ * the squares whose source cells line up across them (see KERNEL_SQUARE)
+ * are filled by a vector transpose instead.
+ ************************/
+#define KERNEL_BLOCKED(NAME, CELL, OP)                                        \
+static inline void NAME##_from(UArray2b_T src, int c, int r, int *src_col,   \
+                               int *src_row)                                  \
+{                                                                             \
+        int sw = src->width;                                                  \
+        int sh = src->height;                                                 \
+        (void)sw;                                                             \
+        (void)sh;                                                             \
+        *src_col = KERNEL_##OP##_COL;                                         \
+        *src_row = KERNEL_##OP##_ROW;                                         \
+}                                                                             \
+static inline const char *NAME##_src(UArray2b_T src, int c, int r)           \
+{                                                                             \
+        int sw = src->width;                                                  \
+        int sh = src->height;                                                 \
+        (void)sw;                                                             \
+        (void)sh;                                                             \
+        return UArray2b_at_unchecked(src, KERNEL_##OP##_COL,                  \
+                                     KERNEL_##OP##_ROW);                      \
+}                                                                             \
+static inline int NAME##_flat(UArray2b_T src, int c, int r, int dc, int dr, \
+                             ptrdiff_t *along, ptrdiff_t *next)               \
+{                                                                             \
+        const int last = SIMDTILE_SIDE - 1;                                   \
+        int sc0, sr0, sc1, sr1;                                               \
+        NAME##_from(src, c, r, &sc0, &sr0);                                   \
+        NAME##_from(src, c + last, r + last, &sc1, &sr1);                     \
+        if (!Kernel_same_micro(src, sc0, sr0, sc1, sr1)) {                    \
+                return 0;                                                     \
+        }                                                                     \
+        if (*next == 0) {                                                     \
+                const char *at = NAME##_src(src, c, r);                       \
+                *along = NAME##_src(src, c + dc, r + dr) - at;                \
+                *next = NAME##_src(src, c + dr, r + dc) - at;                 \
+        }                                                                     \
+        return 1;                                                             \
+}                                                                             \
+KERNEL_SQUARE(NAME, UArray2b_T)                                               \
+static inline void NAME##_line(UArray2b_T src, CELL *out, int n, int c,      \
+                               int r, int dc, int dr)                         \
+{                                                                             \
+        int sc, sr, next_c, next_r;                                           \
+        NAME##_from(src, c, r, &sc, &sr);                                     \
+        NAME##_from(src, c + dc, r + dr, &next_c, &next_r);                   \
+        int dsc = next_c - sc;                                                \
+        int dsr = next_r - sr;                                                \
+        int micro = src->microsize;                                           \
+        int col_major = src->order == UARRAY2B_COL_MAJOR;                     \
+        ptrdiff_t step = dsc != 0 ? dsc * (col_major ? micro : 1)             \
+                                  : dsr * (col_major ? 1 : micro);            \
+        int k = 0;                                                            \
+        while (k < n) {                                                       \
+                int pos = dsc != 0 ? (sc + src->col0) % micro                 \
+                                   : (sr + src->row0) % micro;                \
+                int run = (dsc + dsr) > 0 ? micro - pos : pos + 1;            \
+                if (run > n - k) {                                            \
+                        run = n - k;                                          \
+                }                                                             \
+                const CELL *in = UArray2b_at_unchecked(src, sc, sr);          \
+                for (int i = 0; i < run; i++) {                               \
+                        out[k + i] = *in;                                     \
+                        in += step;                                           \
+                }                                                             \
+                k += run;                                                     \
+                sc += run * dsc;                                              \
+                sr += run * dsr;                                              \
+        }                                                                     \
+}                                                                             \
+static void NAME##_tile(int col, int row, int width, int height, void *base, \
+                        int col_stride, int row_stride, void *vcl)            \
+{                                                                             \
+        const struct Kernel_blocked *cl = vcl;                                \
+        /* the lines of the tile are its columns or its rows */               \
+        int down = (size_t)row_stride == sizeof(CELL);                        \
+        int dc = !down;                                                       \
+        int dr = down;                                                        \
+        int lines = down ? width : height;                                    \
+        int len = down ? height : width;                                      \
+        ptrdiff_t across = down ? col_stride : row_stride;                    \
+        int k = 0;                                                            \
+        ptrdiff_t along = 0;    /* source strides, once a square finds them */\
+        ptrdiff_t next = 0;                                                   \
+        const ptrdiff_t size = sizeof(CELL);                                  \
+        if (KERNEL_##OP##_SWAPS && cl->transpose != NULL) {                   \
+                for (; k + SIMDTILE_SIDE <= lines &&                          \
+                       (next == 0 || next == size || next == -size);          \
+                       k += SIMDTILE_SIDE) {                                  \
+                        char *out = (char *)base + k * across;                \
+                        int i = 0;                                            \
+                        for (; i + SIMDTILE_SIDE <= len;                      \
+                               i += SIMDTILE_SIDE) {                          \
+                                int c = col + k * dr + i * dc;                \
+                                int r = row + k * dc + i * dr;                \
+                                char *at = out + i * size;                    \
+                                if (NAME##_flat(cl->src, c, r, dc, dr,        \
+                                                &along, &next) &&             \
+                                    (next == size || next == -size)) {        \
+                                        NAME##_square(cl->src, at, across, c, \
+                                                      r, along, next,         \
+                                                      cl->transpose);         \
+                                        continue;                             \
+                                }                                             \
+                                for (int j = 0; j < SIMDTILE_SIDE; j++) {     \
+                                        NAME##_line(cl->src, (CELL *)(at +    \
+                                                    j * across),              \
+                                                    SIMDTILE_SIDE, c + j * dr,\
+                                                    r + j * dc, dc, dr);      \
+                                }                                             \
+                        }                                                     \
+                        for (int j = 0; i < len && j < SIMDTILE_SIDE; j++) {  \
+                                NAME##_line(cl->src, (CELL *)(out + j *       \
+                                            across + i * size),               \
+                                            len - i, col + (k + j) * dr +     \
+                                            i * dc, row + (k + j) * dc +      \
+                                            i * dr, dc, dr);                  \
+                        }                                                     \
+                }                                                             \
+        }                                                                     \
+        for (; k < lines; k++) {                                              \
+                NAME##_line(cl->src, (CELL *)((char *)base + k * across),     \
+                            len, col + k * dr, row + k * dc, dc, dr);         \
+        }                                                                     \
+}                                                                             \
+static void NAME(A2Methods_UArray2 vsrc, A2Methods_UArray2 vdst)             \
+{                                                                             \
+        UArray2b_T src = vsrc;                                                \
+        UArray2b_T dst = vdst;                                                \
+        assert((size_t)src->size == sizeof(CELL) &&                           \
+               (size_t)dst->size == sizeof(CELL));                            \
+        struct Kernel_blocked cl = {                                          \
+                src, KERNEL_##OP##_SWAPS ? Simdtile_transpose(sizeof(CELL))   \
+                                         : NULL                               \
+        };                                                                    \
+        UArray2b_map_blocks(dst, NAME##_tile, &cl);                           \
+}
+
+/* 
+ * defines PREFIX_plain_OP, PREFIX_recursive_OP and PREFIX_blocked_OP for 
+ * one op
+ */
+#define KERNEL_BOTH(PREFIX, CELL, OP)                                         \
+        KERNEL_PLAIN(PREFIX##_plain_##OP, CELL, OP)                           \
+        KERNEL_RECURSIVE(PREFIX##_recursive_##OP, CELL,                       \
+                         PREFIX##_plain_##OP##_rect)                          \
+        KERNEL_BLOCKED(PREFIX##_blocked_##OP, CELL, OP)
+
+/* the eight kernels of a layout, indexed by Dihedral_op */
+#define KERNEL_TABLE(PREFIX, LAYOUT)                                          \
+static Kernel_fun *const PREFIX##_##LAYOUT##_kernels[] = {                    \
+        PREFIX##_##LAYOUT##_IDENTITY,                                         \
+        PREFIX##_##LAYOUT##_ROTATE_90,                                        \
+        PREFIX##_##LAYOUT##_ROTATE_180,                                       \
+        PREFIX##_##LAYOUT##_ROTATE_270,                                       \
+        PREFIX##_##LAYOUT##_FLIP_HORIZONTAL,                                  \
+        PREFIX##_##LAYOUT##_FLIP_VERTICAL,                                    \
+        PREFIX##_##LAYOUT##_TRANSPOSE,                                        \
+        PREFIX##_##LAYOUT##_ANTITRANSPOSE,                                    \
+};
+
+/**********KERNEL_DEFINE_ALL********
+ *
+ * Defines every kernel for cells of type CELL, along with
+ *      static Kernel_fun *PREFIX_kernel(A2Methods_T methods, Dihedral_op op)
+ * which returns the kernel for op and the layout of the methods suite, or
+ * NULL if that suite has no kernels (its caller then falls back on
+ * methods->transform or on apply functions), and
+ *      static Kernel_fun *PREFIX_recursive_kernel(A2Methods_T methods, 
+ *                                                 Dihedral_op op)
+ * which returns the recursive kernel for op, or NULL unless methods is the
+ * plain suite
+ ************************/
+#define KERNEL_DEFINE_ALL(PREFIX, CELL)                                       \
+        KERNEL_BOTH(PREFIX, CELL, IDENTITY)                                   \
+        KERNEL_BOTH(PREFIX, CELL, ROTATE_90)                                  \
+        KERNEL_BOTH(PREFIX, CELL, ROTATE_180)                                 \
+        KERNEL_BOTH(PREFIX, CELL, ROTATE_270)                                 \
+        KERNEL_BOTH(PREFIX, CELL, FLIP_HORIZONTAL)                            \
+        KERNEL_BOTH(PREFIX, CELL, FLIP_VERTICAL)                              \
+        KERNEL_BOTH(PREFIX, CELL, TRANSPOSE)                                  \
+        KERNEL_BOTH(PREFIX, CELL, ANTITRANSPOSE)                              \
+        KERNEL_TABLE(PREFIX, plain)                                           \
+        KERNEL_TABLE(PREFIX, recursive)                                       \
+        KERNEL_TABLE(PREFIX, blocked)                                         \
+static Kernel_fun *PREFIX##_kernel(A2Methods_T methods, Dihedral_op op)      \
+{                                                                             \
+        if (methods == uarray2_methods_plain) {                               \
+                return PREFIX##_plain_kernels[op];                            \
+        } else if (methods == uarray2_methods_blocked) {                      \
+                return PREFIX##_blocked_kernels[op];                          \
+        }                                                                     \
+        return NULL;                                                          \
+}                                                                             \
+static Kernel_fun *PREFIX##_recursive_kernel(A2Methods_T methods,            \
+                                             Dihedral_op op)                  \
+{                                                                             \
+        if (methods == uarray2_methods_plain) {                               \
+                return PREFIX##_recursive_kernels[op];                        \
+        }                                                                     \
+        return NULL;                                                          \
+}
+
+#endif
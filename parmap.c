@@ -0,0 +1,334 @@
+/*
+ *     parmap.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of a work-stealing task runner on POSIX
+ *              threads. Each thread owns a range of task indices packed
+ *              into one 64-bit word; the owner takes indices from the front
+ *              of its range and thieves take the back half, both with a
+ *              single compare-and-swap, so no locks are needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "parmap.h"
+
+#define CACHE_LINE 64
+
+/* threads used by Parmap_run; 0 until first needed */
+static int nthreads = 0;
+
+/* statistics accumulated since the last Parmap_reset_stats */
+static double wall_ns = 0;
+static int stats_threads = 0;
+static double busy_ns[PARMAP_MAX_THREADS];
+static long tasks_run[PARMAP_MAX_THREADS];
+static long steals[PARMAP_MAX_THREADS];
+
+/*
+ * the shared state of one Parmap_run
+ * Elements:
+ *      int nworkers: the number of threads taking part
+ *      struct worker *workers: one worker per thread
+ *      void task: the client's task function, and cl its closure
+ */
+struct run {
+        int nworkers;
+        struct worker *workers;
+        void (*task)(int index, void *cl);
+        void *cl;
+};
+
+/*
+ * the state of one thread of a Parmap_run, padded to a cache line so that
+ * updates to one worker's range do not slow down the others
+ * Elements:
+ *      uint64_t range: the task indices [lo, hi) this worker has left, with
+ *              lo in the low 32 bits and hi in the high 32 bits
+ *      int id: the index of this worker in the run
+ *      struct run *run: the run this worker belongs to
+ *      pthread_t thread: the thread running this worker (unused for the
+ *              caller, which is worker 0)
+ *      int started: 1 if thread was created
+ *      double busy_ns, long tasks, long steals: this worker's statistics
+ */
+struct worker {
+        uint64_t range;
+        int id;
+        struct run *run;
+        pthread_t thread;
+        int started;
+        double busy_ns;
+        long tasks;
+        long steals;
+} __attribute__((aligned(CACHE_LINE)));
+
+/**********pack********
+ *
+ * Returns the range [lo, hi) packed into a single word
+ ************************/
+static inline uint64_t pack(uint32_t lo, uint32_t hi)
+{
+        return ((uint64_t)hi << 32) | lo;
+}
+
+/**********now_ns********
+ *
+ * Returns the current monotonic time in nanoseconds
+ ************************/
+static double now_ns(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**********take_own********
+ *
+ * Takes the first index of a worker's own range, storing it in *index.
+ * Returns false if the range is empty.
+ ************************/
+static bool take_own(struct worker *w, int *index)
+{
+        uint64_t old = __atomic_load_n(&w->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+                uint32_t lo = (uint32_t)old;
+                uint32_t hi = (uint32_t)(old >> 32);
+                if (lo >= hi) {
+                        return false;
+                }
+                if (__atomic_compare_exchange_n(&w->range, &old,
+                                                pack(lo + 1, hi), false,
+                                                __ATOMIC_ACQ_REL,
+                                                __ATOMIC_ACQUIRE)) {
+                        *index = lo;
+                        return true;
+                }
+        }
+}
+
+/**********steal********
+ *
+ * Moves the back half (rounded up) of victim's range to thief, whose own
+ * range must be empty. Returns false if victim has nothing left.
+ ************************/
+static bool steal(struct worker *thief, struct worker *victim)
+{
+        uint64_t old = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+                uint32_t lo = (uint32_t)old;
+                uint32_t hi = (uint32_t)(old >> 32);
+                if (lo >= hi) {
+                        return false;
+                }
+                uint32_t mid = hi - (hi - lo + 1) / 2;
+                if (__atomic_compare_exchange_n(&victim->range, &old,
+                                                pack(lo, mid), false,
+                                                __ATOMIC_ACQ_REL,
+                                                __ATOMIC_ACQUIRE)) {
+                        __atomic_store_n(&thief->range, pack(mid, hi),
+                                                        __ATOMIC_RELEASE);
+                        return true;
+                }
+        }
+}
+
+/**********work********
+ *
+ * The body of every thread of a run: runs the tasks of its own range, then
+ * steals from the other workers (starting with its neighbour) until no
+ * worker has anything left. Indices in transit between a victim and a thief
+ * are always run by the thief, so every index is run exactly once.
+ ************************/
+static void *work(void *vw)
+{
+        struct worker *w = vw;
+        struct run *run = w->run;
+        for (;;) {
+                int index;
+                if (take_own(w, &index)) {
+                        double start = now_ns();
+                        run->task(index, run->cl);
+                        w->busy_ns += now_ns() - start;
+                        w->tasks++;
+                        continue;
+                }
+                bool stolen = false;
+                for (int k = 1; k < run->nworkers && !stolen; k++) {
+                        struct worker *victim =
+                                &run->workers[(w->id + k) % run->nworkers];
+                        stolen = steal(w, victim);
+                }
+                if (!stolen) {
+                        return NULL;
+                }
+                w->steals++;
+        }
+}
+
+/**********Parmap_set_threads********
+ *
+ * Sets the number of threads Parmap_run uses, including the caller
+ * Inputs:
+ *              int n: the number of threads, capped at PARMAP_MAX_THREADS
+ * Return: N/A
+ * Expects:
+ *      n to be positive
+ * Notes:
+ *      Checked runtime error if n is less than 1
+ ************************/
+void Parmap_set_threads(int n)
+{
+        assert(n >= 1);
+        nthreads = n < PARMAP_MAX_THREADS ? n : PARMAP_MAX_THREADS;
+}
+
+/**********Parmap_threads********
+ *
+ * Returns the number of threads Parmap_run uses: the value given to
+ * Parmap_set_threads, or the number of online processors if it was never
+ * called
+ ************************/
+int Parmap_threads(void)
+{
+        if (nthreads == 0) {
+                long online = sysconf(_SC_NPROCESSORS_ONLN);
+                Parmap_set_threads(online >= 1 ? online : 1);
+        }
+        return nthreads;
+}
+
+/**********Parmap_run********
+ *
+ * Calls task(index, cl) once for every index in [0, ntasks) using a pool of
+ * work-stealing threads
+ * Inputs:
+ *              int ntasks: the number of tasks
+ *              void task: the function run for each task index
+ *              void *cl: A closure passed to every call of task
+ * Return: N/A, once every task has run
+ * Expects:
+ *      * ntasks to be nonnegative
+ *      * task to be nonnull and safe to call concurrently
+ * Notes:
+ *      * Checked runtime error if ntasks is negative, task is null or the
+ *        workers cannot be allocated
+ *      * The calling thread is worker 0, so a single-threaded run creates no
+ *        threads. If a thread cannot be created its share is stolen by the
+ *        others, so the run still completes.
+ *      * Statistics are added to those reported by Parmap_stats
+ ************************/
+void Parmap_run(int ntasks, void task(int index, void *cl), void *cl)
+{
+        assert(ntasks >= 0);
+        assert(task != NULL);
+        if (ntasks == 0) {
+                return;
+        }
+        int n = Parmap_threads();
+        if (n > ntasks) {
+                n = ntasks;
+        }
+
+        struct worker *workers = NULL;
+        if (posix_memalign((void **)&workers, CACHE_LINE,
+                                        n * sizeof(*workers)) != 0) {
+                workers = NULL;
+        }
+        assert(workers != NULL);
+        struct run run = { n, workers, task, cl };
+        for (int i = 0; i < n; i++) {
+                uint32_t lo = (int64_t)ntasks * i / n;
+                uint32_t hi = (int64_t)ntasks * (i + 1) / n;
+                workers[i] = (struct worker){ pack(lo, hi), i, &run,
+                                              pthread_self(), 0, 0, 0, 0 };
+        }
+
+        double start = now_ns();
+        for (int i = 1; i < n; i++) {
+                workers[i].started = pthread_create(&workers[i].thread, NULL,
+                                                work, &workers[i]) == 0;
+        }
+        work(&workers[0]);
+        for (int i = 1; i < n; i++) {
+                if (workers[i].started) {
+                        pthread_join(workers[i].thread, NULL);
+                }
+        }
+        wall_ns += now_ns() - start;
+
+        for (int i = 0; i < n; i++) {
+                busy_ns[i] += workers[i].busy_ns;
+                tasks_run[i] += workers[i].tasks;
+                steals[i] += workers[i].steals;
+        }
+        if (n > stats_threads) {
+                stats_threads = n;
+        }
+        free(workers);
+}
+
+/**********Parmap_reset_stats********
+ *
+ * Clears the statistics reported by Parmap_wall_ns and Parmap_stats
+ ************************/
+void Parmap_reset_stats(void)
+{
+        wall_ns = 0;
+        for (int i = 0; i < stats_threads; i++) {
+                busy_ns[i] = 0;
+                tasks_run[i] = 0;
+                steals[i] = 0;
+        }
+        stats_threads = 0;
+}
+
+/**********Parmap_wall_ns********
+ *
+ * Returns the wall-clock nanoseconds spent in Parmap_run since the last
+ * Parmap_reset_stats
+ ************************/
+double Parmap_wall_ns(void)
+{
+        return wall_ns;
+}
+
+/**********Parmap_stats_threads********
+ *
+ * Returns the largest number of threads that took part in a Parmap_run
+ * since the last Parmap_reset_stats
+ ************************/
+int Parmap_stats_threads(void)
+{
+        return stats_threads;
+}
+
+/**********Parmap_stats********
+ *
+ * Reports the statistics of one thread since the last Parmap_reset_stats
+ * Inputs:
+ *              int thread: the worker number, 0 being the calling thread
+ *              double *busy_ns: set to the nanoseconds spent running tasks
+ *              long *tasks: set to the number of tasks run
+ *              long *steals: set to the number of successful steals
+ * Return: N/A
+ * Expects:
+ *      0 <= thread < Parmap_stats_threads(), and the pointers to be nonnull
+ * Notes:
+ *      Checked runtime error if any expectation is not met
+ ************************/
+void Parmap_stats(int thread, double *busy, long *tasks, long *stolen)
+{
+        assert(thread >= 0 && thread < stats_threads);
+        assert(busy != NULL && tasks != NULL && stolen != NULL);
+        *busy = busy_ns[thread];
+        *tasks = tasks_run[thread];
+        *stolen = steals[thread];
+}
@@ -0,0 +1,52 @@
+/*
+ *     parmap.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for running a numbered set of independent tasks on
+ *              a pool of threads that steal work from one another. The
+ *              parallel mapping functions of UArray2 and UArray2b split
+ *              their iteration space into tasks (bands of rows or columns,
+ *              or blocks) and hand them to Parmap_run.
+ */
+
+#ifndef PARMAP_INCLUDED
+#define PARMAP_INCLUDED
+
+/* the most threads Parmap_run will use */
+#define PARMAP_MAX_THREADS 256
+
+/*
+ * Sets the number of threads Parmap_run uses, including the calling thread.
+ * It is a checked runtime error for nthreads to be less than 1; values
+ * above PARMAP_MAX_THREADS are capped. The default is the number of online
+ * processors.
+ */
+extern void Parmap_set_threads(int nthreads);
+extern int Parmap_threads(void);
+
+/*
+ * Calls task(index, cl) once for every index in [0, ntasks), on up to
+ * Parmap_threads() threads, and returns when all the calls have returned.
+ * Each thread starts with an equal share of the indices and, once its share
+ * is used up, steals half of what is left of another thread's share. Calls
+ * may run concurrently and in any order, so task must be safe to call from
+ * several threads at once for different indices. It is a checked runtime
+ * error for ntasks to be negative or task to be NULL.
+ */
+extern void Parmap_run(int ntasks, void task(int index, void *cl), void *cl);
+
+/*
+ * Statistics accumulated over every Parmap_run since the last
+ * Parmap_reset_stats: the wall-clock nanoseconds spent inside Parmap_run,
+ * and for each thread (0 is the caller) the nanoseconds it spent running
+ * tasks, the number of tasks it ran and the number of times it stole work.
+ * Parmap_stats_threads returns the number of threads that have taken part.
+ */
+extern void Parmap_reset_stats(void);
+extern double Parmap_wall_ns(void);
+extern int Parmap_stats_threads(void);
+extern void Parmap_stats(int thread, double *busy_ns, long *tasks,
+                         long *steals);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ *     pitch_bench.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Benchmark for UArray2 row padding. Times the work done by
+ *              ppmtrans -col-major -rotate 90 (a column-major walk of the
+ *              source writing whole rows of the destination) on images
+ *              whose rows do and do not alias in the cache, with padding
+ *              turned off and on.
+ *
+ *     Usage: pitch_bench [height]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "uarray2.h"
+#include "cputiming.h"
+
+/* three unsigned channels, the same size as a struct Pnm_rgb */
+struct pixel {
+        unsigned red, green, blue;
+};
+
+/**********rotate_ninety********
+ *
+ * Apply function that copies the pixel at (col, row) of the source to its
+ * place in the source rotated 90 degrees clockwise, which is the UArray2
+ * passed as the closure
+ ************************/
+static void rotate_ninety(int col, int row, UArray2_T src, void *elem,
+                                                                void *cl)
+{
+        UArray2_T dst = cl;
+        struct pixel *out = UArray2_at(dst, UArray2_height(src) - row - 1,
+                                                                        col);
+        *out = *(struct pixel *)elem;
+}
+
+/**********fill********
+ *
+ * Apply function that gives every pixel a distinct value
+ ************************/
+static void fill(int col, int row, UArray2_T src, void *elem, void *cl)
+{
+        (void)src;
+        (void)cl;
+        struct pixel *p = elem;
+        p->red = col;
+        p->green = row;
+        p->blue = col ^ row;
+}
+
+/**********time_rotation********
+ *
+ * Returns the time per pixel, in nanoseconds, of rotating a width x height
+ * image 90 degrees with a column-major map, with row padding enabled or
+ * disabled for both images
+ ************************/
+static double time_rotation(int width, int height, int padded)
+{
+        UArray2_set_padding(padded);
+        UArray2_T src = UArray2_new(width, height, sizeof(struct pixel));
+        UArray2_T dst = UArray2_new(height, width, sizeof(struct pixel));
+        UArray2_map_row_major(src, fill, NULL);
+
+        CPUTime_T timer = CPUTime_New();
+        CPUTime_Start(timer);
+        UArray2_map_col_major(src, rotate_ninety, dst);
+        double time_used = CPUTime_Stop(timer);
+        CPUTime_Free(&timer);
+
+        UArray2_free(&src);
+        UArray2_free(&dst);
+        return time_used / ((double)width * height);
+}
+
+int main(int argc, char *argv[])
+{
+        int height = argc > 1 ? atoi(argv[1]) : 2048;
+        const int widths[] = { 4000, 4096, 8000, 8192 };
+        const int nwidths = sizeof(widths) / sizeof(widths[0]);
+
+        if (height < 1) {
+                fprintf(stderr, "Usage: %s [height]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+
+        printf("col-major rotate 90, height %d\n", height);
+        printf("%8s %14s %14s\n", "width", "unpadded ns", "padded ns");
+        for (int i = 0; i < nwidths; i++) {
+                double unpadded = time_rotation(widths[i], height, 0);
+                double padded = time_rotation(widths[i], height, 1);
+                printf("%8d %14.2f %14.2f\n", widths[i], unpadded, padded);
+        }
+
+        UArray2_set_padding(1);
+        return EXIT_SUCCESS;
+}
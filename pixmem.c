@@ -0,0 +1,180 @@
+/*
+ *     pixmem.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of cell storage allocation for large 2D arrays.
+ *              Ordinary storage comes from posix_memalign. Huge page storage
+ *              is an anonymous mmap trimmed to a 2MB boundary and advised 
+ *              with MADV_HUGEPAGE, so that a 150MB image needs tens of TLB 
+ *              entries instead of tens of thousands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include "pixmem.h"
+
+#define CACHE_LINE 64
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+static int huge_pages = 0;
+static size_t huge_requested = 0;
+static size_t huge_advised = 0;
+
+/**********round_up********
+ *
+ * Returns n rounded up to a multiple of unit, which must be a power of two
+ ************************/
+static size_t round_up(size_t n, size_t unit)
+{
+        return (n + unit - 1) & ~(unit - 1);
+}
+
+/**********huge_alloc********
+ *
+ * Returns nbytes (a multiple of HUGE_PAGE) of 2MB-aligned anonymous memory,
+ * advised with MADV_HUGEPAGE where the kernel supports it, or NULL if the 
+ * memory cannot be mapped. Anonymous mappings are already zero-filled.
+ ************************/
+static void *huge_alloc(size_t nbytes)
+{
+        size_t span = nbytes + HUGE_PAGE;
+        char *raw = mmap(NULL, span, PROT_READ | PROT_WRITE, 
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+                return NULL;
+        }
+
+        /* trim the mapping to a 2MB-aligned region of nbytes */
+        char *mem = (char *)round_up((uintptr_t)raw, HUGE_PAGE);
+        size_t head = mem - raw;
+        size_t tail = span - head - nbytes;
+        if (head > 0) {
+                munmap(raw, head);
+        }
+        if (tail > 0) {
+                munmap(mem + nbytes, tail);
+        }
+
+        huge_requested += nbytes;
+#ifdef MADV_HUGEPAGE
+        if (madvise(mem, nbytes, MADV_HUGEPAGE) == 0) {
+                huge_advised += nbytes;
+        }
+#endif
+        return mem;
+}
+
+/**********Pixmem_alloc********
+ *
+ * Allocates zero-filled storage for the cells of an array
+ * Inputs:
+ *              size_t nbytes: the number of bytes needed
+ *              int *mapped: set to 1 if the storage is an mmap region and 0
+ *                           if it came from the heap
+ * Return: a pointer to the storage, aligned to at least a cache line
+ * Expects:
+ *      mapped to be nonnull
+ * Notes:
+ *      Checked runtime error if mapped is null or the storage cannot be 
+ *      allocated
+ *      Huge page storage is used only when enabled with 
+ *      Pixmem_set_huge_pages and the region is at least one huge page;
+ *      otherwise (or if mmap fails) ordinary heap storage is used
+ *      The storage must be released with Pixmem_free
+ ************************/
+void *Pixmem_alloc(size_t nbytes, int *mapped)
+{
+        assert(mapped != NULL);
+        if (huge_pages && nbytes >= HUGE_PAGE) {
+                void *mem = huge_alloc(round_up(nbytes, HUGE_PAGE));
+                if (mem != NULL) {
+                        *mapped = 1;
+                        return mem;
+                }
+        }
+
+        size_t rounded = round_up(nbytes > 0 ? nbytes : 1, CACHE_LINE);
+        void *mem = NULL;
+        if (posix_memalign(&mem, CACHE_LINE, rounded) != 0) {
+                mem = NULL;
+        }
+        assert(mem != NULL);
+        memset(mem, 0, rounded);
+        *mapped = 0;
+        return mem;
+}
+
+/**********Pixmem_free********
+ *
+ * Releases storage obtained from Pixmem_alloc
+ * Inputs:
+ *              void *mem: the storage
+ *              size_t nbytes: the size that was passed to Pixmem_alloc
+ *              int mapped: the value Pixmem_alloc stored in *mapped
+ * Return: N/A
+ ************************/
+void Pixmem_free(void *mem, size_t nbytes, int mapped)
+{
+        if (mapped) {
+                munmap(mem, round_up(nbytes, HUGE_PAGE));
+        } else {
+                free(mem);
+        }
+}
+
+/**********Pixmem_set_huge_pages********
+ *
+ * Selects whether later calls to Pixmem_alloc try huge page storage
+ * Inputs:
+ *              int enabled: nonzero to try huge pages
+ * Return: N/A
+ ************************/
+void Pixmem_set_huge_pages(int enabled)
+{
+        huge_pages = enabled != 0;
+}
+
+/**********Pixmem_huge_requested********
+ *
+ * Returns the total bytes mapped for huge page storage so far
+ ************************/
+size_t Pixmem_huge_requested(void)
+{
+        return huge_requested;
+}
+
+/**********Pixmem_huge_advised********
+ *
+ * Returns the total bytes for which madvise(MADV_HUGEPAGE) succeeded
+ ************************/
+size_t Pixmem_huge_advised(void)
+{
+        return huge_advised;
+}
+
+/**********Pixmem_huge_resident_kb********
+ *
+ * Returns the kB of this process's anonymous memory currently backed by 
+ * huge pages, as reported by the kernel, or -1 if it cannot be read
+ ************************/
+long Pixmem_huge_resident_kb(void)
+{
+        FILE *fp = fopen("/proc/self/smaps_rollup", "r");
+        if (fp == NULL) {
+                return -1;
+        }
+        char line[256];
+        long kb = -1;
+        while (fgets(line, sizeof(line), fp) != NULL) {
+                if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) {
+                        break;
+                }
+        }
+        fclose(fp);
+        return kb;
+}
@@ -0,0 +1,39 @@
+/*
+ *     pixmem.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for allocating the cell storage of large 2D arrays,
+ *              optionally backed by transparent huge pages
+ */
+
+#ifndef PIXMEM_INCLUDED
+#define PIXMEM_INCLUDED
+
+#include <stddef.h>
+
+/* 
+ * Returns nbytes of zero-filled storage aligned to at least a cache line.
+ * When huge pages are enabled, the storage is a 2MB-aligned mmap region 
+ * advised with MADV_HUGEPAGE, falling back to ordinary memory if that is not
+ * possible. *mapped is set to 1 for mmap storage and 0 otherwise, and must be
+ * handed back to Pixmem_free with the same nbytes. It is a checked runtime
+ * error for the storage not to be available.
+ */
+extern void *Pixmem_alloc(size_t nbytes, int *mapped);
+extern void Pixmem_free(void *mem, size_t nbytes, int mapped);
+
+/* selects whether later calls to Pixmem_alloc try to use huge pages */
+extern void Pixmem_set_huge_pages(int enabled);
+
+/* 
+ * Reports on the huge page requests made so far: the number of bytes
+ * requested with MADV_HUGEPAGE, the number for which the kernel accepted the
+ * advice, and the kB currently backed by huge pages in this process 
+ * (AnonHugePages in /proc/self/smaps_rollup, or -1 if unavailable)
+ */
+extern size_t Pixmem_huge_requested(void);
+extern size_t Pixmem_huge_advised(void);
+extern long Pixmem_huge_resident_kb(void);
+
+#endif
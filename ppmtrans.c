@@ -12,18 +12,44 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <math.h>
+#include <sys/resource.h>
 
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2morton.h"
+#include "uarray2.h"
+#include "uarray2_impl.h"
+#include "uarray2b.h"
+#include "uarray2b_impl.h"
+#include "pixmem.h"
+#include "parmap.h"
 #include "pnm.h"
 #include "cputiming.h"
+#include "kernels.h"
+#include "a2convert.h"
+#include "simdtile.h"
+#include "resample.h"
 
 
 void transform_image(A2Methods_mapfun *map, Pnm_ppm new_image, 
                      Pnm_ppm og_image, int width, int height, 
                      A2Methods_applyfun apply, A2Methods_T methods);
+void transform_rows(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                    A2Methods_T methods);
+void transform_layout(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                      Kernel_fun *kernel, A2Methods_T methods);
+void transform_in_place(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                        A2Methods_T methods);
+void rotate_image(Pnm_ppm new_image, Pnm_ppm og_image, double degrees,
+                  Resample_filter filter, const struct Pnm_rgb *background,
+                  A2Methods_T methods);
+void scale_image(Pnm_ppm new_image, Pnm_ppm og_image, int width, int height,
+                 Resample_filter filter, A2Methods_T methods);
+void crop_image(Pnm_ppm image, const int crop[4], A2Methods_T methods, 
+                const char *progname);
 
 /**************************************************
  *******  Transformation Apply Functions  *********
@@ -40,6 +66,8 @@ void flip_vertical(int col, int row, A2Methods_UArray2 A2uarray2,
                                                         void *elem, void *cl);
 void transpose(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl);
+void antitranspose(int col, int row, A2Methods_UArray2 A2uarray2, 
+                                                        void *elem, void *cl);
 
 /************************************
  *******  Timing Functions  *********
@@ -48,7 +76,7 @@ void transpose(int col, int row, A2Methods_UArray2 A2uarray2,
 CPUTime_T start_timer();
 
 void stop_timer(CPUTime_T timer, FILE *time_file, A2Methods_T methods, 
-                                                        Pnm_ppm og_image);
+                Pnm_ppm og_image, bool in_place, long written, int threads);
 
 #define SET_METHODS(METHODS, MAP, WHAT) do {                    \
         methods = (METHODS);                                    \
@@ -69,21 +97,134 @@ void stop_timer(CPUTime_T timer, FILE *time_file, A2Methods_T methods,
  *                      A2Methods_UArray2 instances within the apply function
  *      A2Methods_UArray2 uarray2:  The UArray2_T or UArray2b_T to hold the 
  *                      transformed image.
+ *      int width, height: The dimensions of the original image, so that 
+ *                      apply functions need not ask the methods suite for
+ *                      them at every pixel
  */
 struct closure {
         A2Methods_T method_suite;
         A2Methods_UArray2 uarray2;
+        int width;
+        int height;
 };
 
-/* Global constants used to identify user commanded transformations */
-#define HORIZONTAL -1
-#define VERTICAL -2
-#define TRANSPOSE -3
+/**********pixel_at********
+ *
+ * Returns the pixel at (col, row) of the image being built by a 
+ * transformation
+ * Notes:
+ *      In release builds (compiled with -DNDEBUG) the pixels of plain and 
+ *      blocked images are located with the inline unchecked accessors, so
+ *      the hot loops make no calls per pixel besides the apply function 
+ *      itself. Otherwise every access goes through the checked methods->at.
+ ************************/
+static inline Pnm_rgb pixel_at(struct closure *cl, int col, int row)
+{
+#ifdef NDEBUG
+        if (cl->method_suite == uarray2_methods_plain) {
+                return UArray2_at_unchecked(cl->uarray2, col, row);
+        } else if (cl->method_suite == uarray2_methods_blocked) {
+                return UArray2b_at_unchecked(cl->uarray2, col, row);
+        }
+#endif
+        return cl->method_suite->at(cl->uarray2, col, row);
+}
+
+/* 
+ * rgb_kernel(methods, op) returns the transformation kernel, specialized 
+ * for Pnm_rgb pixels, for op and the layout of methods, or NULL
+ */
+KERNEL_DEFINE_ALL(rgb, struct Pnm_rgb)
+
+/**********rotation_op********
+ *
+ * Returns the symmetry of the rectangle performed by a clockwise rotation 
+ * of 0, 90, 180 or 270 degrees
+ ************************/
+static Dihedral_op rotation_op(int degrees)
+{
+        switch (degrees) {
+        case 90:
+                return DIHEDRAL_ROTATE_90;
+        case 180:
+                return DIHEDRAL_ROTATE_180;
+        case 270:
+                return DIHEDRAL_ROTATE_270;
+        default:
+                assert(degrees == 0);
+                return DIHEDRAL_IDENTITY;
+        }
+}
+
+/**********reduce_degrees********
+ *
+ * Returns the angle in [0, 360) degrees that turns as far as degrees
+ ************************/
+static double reduce_degrees(double degrees)
+{
+        degrees = fmod(degrees, 360.0);
+        return degrees < 0 ? degrees + 360.0 : degrees;
+}
+
+/**********apply_of********
+ *
+ * Returns the transformation apply function that performs op
+ ************************/
+static A2Methods_applyfun *apply_of(Dihedral_op op)
+{
+        switch (op) {
+        case DIHEDRAL_ROTATE_90:
+                return rotate_ninety;
+        case DIHEDRAL_ROTATE_180:
+                return rotate_one_eighty;
+        case DIHEDRAL_ROTATE_270:
+                return rotate_two_seventy;
+        case DIHEDRAL_FLIP_HORIZONTAL:
+                return flip_horizontal;
+        case DIHEDRAL_FLIP_VERTICAL:
+                return flip_vertical;
+        case DIHEDRAL_TRANSPOSE:
+                return transpose;
+        case DIHEDRAL_ANTITRANSPOSE:
+                return antitranspose;
+        default:
+                assert(op == DIHEDRAL_IDENTITY);
+                return NULL;
+        }
+}
+
+/**********parallel_map********
+ *
+ * Returns the parallel counterpart, in the same methods suite, of one of 
+ * its serial mapping functions, or NULL if the suite has none
+ ************************/
+static A2Methods_mapfun *parallel_map(A2Methods_T methods, 
+                                      A2Methods_mapfun *map)
+{
+        if (map == methods->map_row_major) {
+                return methods->par_map_row_major;
+        } else if (map == methods->map_col_major) {
+                return methods->par_map_col_major;
+        } else if (map == methods->map_block_major) {
+                return methods->par_map_block_major;
+        }
+        return NULL;
+}
 
 static void usage(const char *progname)
 {
-        fprintf(stderr, "Usage: %s [-rotate <angle>] "
-                        "[-{row,col,block}-major] [filename]\n",
+        fprintf(stderr, "Usage: %s [-rotate <degrees> | "
+                        "-flip {horizontal,vertical} | -transpose]... "
+                        "[-{row,col,block,morton}-major] "
+                        "[-blocksize <n>] [-two-level] "
+                        "[-block-order {row,col}] [-hugepages] [-no-pad] "
+                        "[-crop x,y,w,h] [-threads <n>] [-callbacks] "
+                        "[-no-kernels] [-io-plain] [-recursive] "
+                        "[-simd {scalar,sse2,avx2}] [-inplace] [-no-inplace] "
+                        "[-scale <width>x<height>] "
+                        "[-filter {nearest,bilinear,box,lanczos}] "
+                        "[-background r,g,b] "
+                        "[filename]\n",
                         progname);
         exit(1);
 }
@@ -91,8 +232,23 @@ static void usage(const char *progname)
 int main(int argc, char *argv[]) 
 {
         char *time_file_name = NULL;
-        int   rotation       = 0;
+        Dihedral_op op       = DIHEDRAL_IDENTITY;   /* the steps so far */
+        double angle         = 0.0;   /* clockwise turn done after op */
+        Resample_filter filter = RESAMPLE_BILINEAR;
+        bool  scaling        = false;   /* -scale was given */
+        int   scale[2];                 /* width, height; 0 keeps aspect */
+        struct Pnm_rgb background = { 0, 0, 0 };
         int   i;
+        bool  cropping       = false;
+        bool  callbacks      = false;   /* map with apply functions */
+        bool  kernels        = true;    /* use the specialized kernels */
+        bool  io_plain       = false;   /* read and write as plain arrays */
+        bool  recursive      = false;   /* use the recursive kernels */
+        bool  simd_chosen    = false;   /* -simd was given */
+        bool  inplace_ok     = true;    /* flip in place when possible */
+        bool  inplace_asked  = false;   /* -inplace was given */
+        int   threads        = 0;   /* 0 for the serial maps */
+        int   crop[4];              /* x, y, width, height */
         FILE *input_stream = NULL;
 
         /* default to UArray2 methods */
@@ -103,6 +259,14 @@ int main(int argc, char *argv[])
         A2Methods_mapfun *map = methods->map_default; 
         assert(map);
 
+        /* 
+         * -rotate, -flip and -transpose may be given any number of times, in
+         * the order they are to be done; each is composed into op, so the 
+         * whole chain is carried out in one pass over the pixels. Turns that
+         * are not right angles add up in angle, which is done after op:
+         * a flip or transpose F after a turn by a is the same as F followed
+         * by a turn by -a, so it composes into op and negates angle.
+         */
         for (i = 1; i < argc; i++) {
                 if (strcmp(argv[i], "-row-major") == 0) {
                         SET_METHODS(uarray2_methods_plain, map_row_major, 
@@ -113,36 +277,167 @@ int main(int argc, char *argv[])
                 } else if (strcmp(argv[i], "-block-major") == 0) {
                         SET_METHODS(uarray2_methods_blocked, map_block_major,
                                     "block-major");
+                } else if (strcmp(argv[i], "-morton-major") == 0) {
+                        SET_METHODS(uarray2_methods_morton, map_default,
+                                    "morton-major");
                 } else if (strcmp(argv[i], "-rotate") == 0) {
                         if (!(i + 1 < argc)) {      /* no rotate value */
                                 usage(argv[0]);
                         }
                         char *endptr;
-                        rotation = strtol(argv[++i], &endptr, 10);
-                        if (!(rotation == 0 || rotation == 90 ||
-                            rotation == 180 || rotation == 270)) {
-                                fprintf(stderr, 
-                                        "Rotation must be 0, 90 180 or 270\n");
+                        double degrees = strtod(argv[++i], &endptr);
+                        if (endptr == argv[i] || !(*endptr == '\0') ||
+                            !isfinite(degrees)) {    /* Not a number */
+                                usage(argv[0]);
+                        }
+                        degrees = reduce_degrees(degrees);
+                        if (fmod(degrees, 90.0) == 0.0) {
+                                op = Dihedral_compose(op, 
+                                                rotation_op((int)degrees));
+                        } else {
+                                angle += degrees;
+                        }
+                } else if (strcmp(argv[i], "-blocksize") == 0) {
+                        if (!(i + 1 < argc)) {      /* no blocksize value */
+                                usage(argv[0]);
+                        }
+                        char *endptr;
+                        int blocksize = strtol(argv[++i], &endptr, 10);
+                        if (!(*endptr == '\0') || blocksize < 1) {
+                                usage(argv[0]);
+                        }
+                        UArray2b_set_blocksize(blocksize);
+                } else if (strcmp(argv[i], "-two-level") == 0) {
+                        UArray2b_set_two_level(1);
+                } else if (strcmp(argv[i], "-block-order") == 0) {
+                        if (!(i + 1 < argc)) {      /* no order value */
+                                usage(argv[0]);
+                        }
+                        i++;
+                        if (strcmp(argv[i], "row") == 0) {
+                                UArray2b_set_order(UARRAY2B_ROW_MAJOR);
+                        } else if (strcmp(argv[i], "col") == 0) {
+                                UArray2b_set_order(UARRAY2B_COL_MAJOR);
+                        } else {   /* Not a possible order */
+                                fprintf(stderr, "%s: unknown block order "
+                                                "'%s'\n", argv[0], argv[i]);
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-hugepages") == 0) {
+                        Pixmem_set_huge_pages(1);
+                } else if (strcmp(argv[i], "-no-pad") == 0) {
+                        UArray2_set_padding(0);
+                } else if (strcmp(argv[i], "-crop") == 0) {
+                        if (!(i + 1 < argc)) {      /* no window */
+                                usage(argv[0]);
+                        }
+                        char extra;
+                        if (sscanf(argv[++i], "%d,%d,%d,%d%c", &crop[0], 
+                                   &crop[1], &crop[2], &crop[3], &extra) != 4
+                            || crop[0] < 0 || crop[1] < 0 || crop[2] < 0 
+                            || crop[3] < 0) {
                                 usage(argv[0]);
                         }
-                        if (!(*endptr == '\0')) {    /* Not a number */
+                        cropping = true;
+                } else if (strcmp(argv[i], "-threads") == 0) {
+                        if (!(i + 1 < argc)) {      /* no thread count */
                                 usage(argv[0]);
                         }
+                        char *endptr;
+                        threads = strtol(argv[++i], &endptr, 10);
+                        if (!(*endptr == '\0') || threads < 1) {
+                                usage(argv[0]);
+                        }
+                        Parmap_set_threads(threads);
+                } else if (strcmp(argv[i], "-callbacks") == 0) {
+                        callbacks = true;
+                } else if (strcmp(argv[i], "-no-kernels") == 0) {
+                        kernels = false;
+                } else if (strcmp(argv[i], "-io-plain") == 0) {
+                        io_plain = true;
+                } else if (strcmp(argv[i], "-recursive") == 0) {
+                        recursive = true;
+                } else if (strcmp(argv[i], "-simd") == 0) {
+                        if (!(i + 1 < argc)) {      /* no instruction set */
+                                usage(argv[0]);
+                        }
+                        simd_chosen = true;
+                        i++;
+                        if (strcmp(argv[i], "scalar") == 0) {
+                                Simdtile_limit(SIMDTILE_SCALAR);
+                        } else if (strcmp(argv[i], "sse2") == 0) {
+                                Simdtile_limit(SIMDTILE_SSE2);
+                        } else if (strcmp(argv[i], "avx2") == 0) {
+                                Simdtile_limit(SIMDTILE_AVX2);
+                        } else {   /* Not a known instruction set */
+                                fprintf(stderr, "%s: unknown instruction "
+                                                "set '%s'\n", argv[0], argv[i]);
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-inplace") == 0) {
+                        inplace_ok = true;
+                        inplace_asked = true;
+                } else if (strcmp(argv[i], "-no-inplace") == 0) {
+                        inplace_ok = false;
+                        inplace_asked = false;
                 } else if (strcmp(argv[i], "-time") == 0) {
                         time_file_name = argv[++i];
                 } else if (strcmp(argv[i], "-flip") == 0) {
                         i++;
                         if (strcmp(argv[i], "horizontal") == 0) {
-                                rotation = HORIZONTAL;
+                                op = Dihedral_compose(op, 
+                                                DIHEDRAL_FLIP_HORIZONTAL);
                         } else if (strcmp(argv[i], "vertical") == 0) {
-                                rotation = VERTICAL;
+                                op = Dihedral_compose(op, 
+                                                DIHEDRAL_FLIP_VERTICAL);
                         } else {   /* Not a possible flip */
                                 fprintf(stderr, "%s: unknown option '%s'\n", 
                                                         argv[0], argv[i++]);
                                 usage(argv[0]);
                         }
+                        angle = -angle;
                 } else if (strcmp(argv[i], "-transpose") == 0) {
-                        rotation = TRANSPOSE;
+                        op = Dihedral_compose(op, DIHEDRAL_TRANSPOSE);
+                        angle = -angle;
+                } else if (strcmp(argv[i], "-filter") == 0) {
+                        if (!(i + 1 < argc)) {      /* no filter name */
+                                usage(argv[0]);
+                        }
+                        i++;
+                        if (strcmp(argv[i], "nearest") == 0) {
+                                filter = RESAMPLE_NEAREST;
+                        } else if (strcmp(argv[i], "bilinear") == 0) {
+                                filter = RESAMPLE_BILINEAR;
+                        } else if (strcmp(argv[i], "box") == 0) {
+                                filter = RESAMPLE_BOX;
+                        } else if (strcmp(argv[i], "lanczos") == 0) {
+                                filter = RESAMPLE_LANCZOS;
+                        } else {   /* Not a known filter */
+                                fprintf(stderr, "%s: unknown filter '%s'\n",
+                                                argv[0], argv[i]);
+                                usage(argv[0]);
+                        }
+                } else if (strcmp(argv[i], "-scale") == 0) {
+                        if (!(i + 1 < argc)) {      /* no size */
+                                usage(argv[0]);
+                        }
+                        char extra;
+                        if (sscanf(argv[++i], "%dx%d%c", &scale[0], 
+                                   &scale[1], &extra) != 2 || scale[0] < 0
+                            || scale[1] < 0 || scale[0] + scale[1] == 0) {
+                                usage(argv[0]);
+                        }
+                        scaling = true;
+                } else if (strcmp(argv[i], "-background") == 0) {
+                        if (!(i + 1 < argc)) {      /* no colour */
+                                usage(argv[0]);
+                        }
+                        char extra;
+                        if (sscanf(argv[++i], "%u,%u,%u%c", &background.red,
+                                   &background.green, &background.blue,
+                                   &extra) != 3) {
+                                usage(argv[0]);
+                        }
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n", argv[0],
                                 argv[i]);
@@ -155,6 +450,28 @@ int main(int argc, char *argv[])
                 }
         }
 
+        /* turns that add up to a right angle join the other steps */
+        angle = reduce_degrees(angle);
+        if (fmod(angle, 90.0) == 0.0) {
+                op = Dihedral_compose(op, rotation_op((int)angle));
+                angle = 0.0;
+        }
+
+        if (recursive && methods != uarray2_methods_plain) {
+                fprintf(stderr, "%s: -recursive needs -row-major or "
+                                "-col-major\n", argv[0]);
+                exit(1);
+        }
+
+        if (threads > 0) {
+                map = parallel_map(methods, map);
+                if (map == NULL) {
+                        fprintf(stderr, "%s does not support parallel "
+                                        "mapping in this order\n", argv[0]);
+                        exit(1);
+                }
+        }
+
         if (i < argc) {
                 input_stream = fopen(argv[i], "r");
         } else {
@@ -166,8 +483,26 @@ int main(int argc, char *argv[])
                 return EXIT_FAILURE;
         }
 
+        /* 
+         * With -io-plain the image is read and written in the plain layout
+         * and converted to and from the layout that transforms it
+         */
+        A2Methods_T io_methods = io_plain ? uarray2_methods_plain : methods;
+
         /* Instantiates all potentially necessary objects */
-        Pnm_ppm og_image = Pnm_ppmread(input_stream, methods);
+        Pnm_ppm og_image = Pnm_ppmread(input_stream, io_methods);
+        A2Methods_UArray2 full_pixels = og_image->pixels;
+        if (cropping) {
+                crop_image(og_image, crop, io_methods, argv[0]);
+        }
+        if (background.red > og_image->denominator || 
+            background.green > og_image->denominator ||
+            background.blue > og_image->denominator) {
+                fprintf(stderr, "%s: -background is brighter than the "
+                                "image's maximum value %u\n", argv[0],
+                                og_image->denominator);
+                exit(1);
+        }
         Pnm_ppm new_image = malloc(sizeof(struct Pnm_ppm));
         CPUTime_T timer = NULL;
         FILE *time_file = NULL;
@@ -178,40 +513,191 @@ int main(int argc, char *argv[])
                 timer = start_timer();
         }
 
+        /* the image to transform, in the layout of methods */
+        struct Pnm_ppm converted = *og_image;
+        Pnm_ppm image = og_image;
+        bool turned = op != DIHEDRAL_IDENTITY || angle != 0.0;
+        bool changed = turned || scaling;
+        if (io_methods != methods && changed) {
+                converted.pixels = A2convert_new(methods, io_methods, 
+                                                 og_image->pixels);
+                converted.methods = methods;
+                image = &converted;
+        }
+
+        /* 
+         * The vector tile transposes pay off in the plain kernels, but the
+         * blocked kernels already copy whole runs of a micro-tile per line
+         * and are faster without them unless they are asked for
+         */
+        if (!simd_chosen && methods == uarray2_methods_blocked) {
+                Simdtile_limit(SIMDTILE_SCALAR);
+        }
+
+        /* 
+         * The layout moves the pixels itself, in the order that suits both
+         * images, unless apply functions were asked for or the parallel 
+         * maps (which call apply functions) are in use. A kernel specialized
+         * for the transformation and layout does the moving when there is 
+         * one, and the layout's generic transform otherwise. -recursive 
+         * selects the cache-oblivious kernels of the plain layout instead.
+         */
+        Kernel_fun *kernel = NULL;
+        if (op != DIHEDRAL_IDENTITY && recursive) {
+                kernel = rgb_recursive_kernel(methods, op);
+                assert(kernel != NULL);
+        } else if (op != DIHEDRAL_IDENTITY && kernels) {
+                kernel = rgb_kernel(methods, op);
+        }
+        bool by_layout = op != DIHEDRAL_IDENTITY && 
+                         (recursive || (!callbacks && threads == 0 && 
+                          (kernel != NULL || methods->transform != NULL)));
+
+        /* 
+         * Flips and 180 degree rotation move whole rows when the layout can
+         * describe them and rows are being visited in order anyway
+         */
+        bool by_rows = methods->row_span != NULL && 
+                       map == methods->map_row_major &&
+                       op != DIHEDRAL_IDENTITY && !Dihedral_swaps(op);
+
+        /* 
+         * The flips and the half turn keep the dimensions and are their own
+         * inverses, so the layout can swap the pixels of the image among 
+         * themselves instead of filling a second image, which halves the 
+         * memory the transformation needs. The apply functions and the 
+         * parallel maps still build a new image, as does -recursive, unless
+         * -inplace is given. The quarter turns and the transpose are done 
+         * in place only with -inplace, by the plain layout, which reshapes
+         * the image's own array.
+         */
+        bool keeps_shape = op != DIHEDRAL_IDENTITY && !Dihedral_swaps(op);
+        bool in_place = inplace_ok && methods->transform_in_place != NULL &&
+                        ((keeps_shape && (inplace_asked || (!callbacks && 
+                                          threads == 0 && !recursive))) ||
+                         (op != DIHEDRAL_IDENTITY && inplace_asked));
+        if (inplace_asked && op != DIHEDRAL_IDENTITY && !keeps_shape) {
+                if (methods != uarray2_methods_plain) {
+                        fprintf(stderr, "%s: -inplace needs -row-major or "
+                                        "-col-major to turn or transpose\n",
+                                        argv[0]);
+                        exit(1);
+                } else if (cropping && crop[2] != crop[3]) {
+                        fprintf(stderr, "%s: -inplace can only turn or "
+                                        "transpose a square crop window\n",
+                                        argv[0]);
+                        exit(1);
+                }
+        }
+
         /* Performs the commanded transformation */
-        if (rotation == 90) {
-                transform_image(map, new_image, og_image, og_image->height, 
-                                og_image->width, rotate_ninety, methods);
-        } else if (rotation == 180) {
-                transform_image(map, new_image, og_image, og_image->width, 
-                                og_image->height, rotate_one_eighty, methods);
-        } else if (rotation == 270) {
-                transform_image(map, new_image, og_image, og_image->height, 
-                                og_image->width, rotate_two_seventy, methods);
-        } else if (rotation == HORIZONTAL) {
-                transform_image(map, new_image, og_image, og_image->width, 
-                                og_image->height, flip_horizontal, methods);
-        } else if (rotation == VERTICAL) {
-                transform_image(map, new_image, og_image, og_image->width, 
-                                og_image->height, flip_vertical, methods);
-        } else if (rotation == TRANSPOSE) {
-                transform_image(map, new_image, og_image, og_image->height, 
-                                og_image->width, transpose, methods);
-        }
-
-        /* writes the transformed image to stdout */
-        if (rotation == 0) {
+        if (in_place) {
+                transform_in_place(new_image, image, op,
+                                   methods);
+        } else if (by_layout) {
+                transform_layout(new_image, image, op,
+                                 kernel, methods);
+        } else if (by_rows) {
+                transform_rows(new_image, image, op, methods);
+        } else if (Dihedral_swaps(op)) {
+                transform_image(map, new_image, image, image->height, 
+                                image->width, apply_of(op), methods);
+        } else if (op != DIHEDRAL_IDENTITY) {
+                transform_image(map, new_image, image, image->width, 
+                                image->height, apply_of(op), methods);
+        }
+
+        /* 
+         * A turn that is not a right angle resamples the result of the
+         * steps above into a canvas that holds all of it. The cap on the
+         * vector routines that suits the blocked kernels is lifted, since
+         * the interpolation gains from AVX2 in every layout. The box and
+         * Lanczos filters are for -scale; a turn with either is bilinear.
+         */
+        bool shared = in_place;     /* new_image holds image's pixels */
+        if (angle != 0.0) {
+                struct Pnm_ppm unturned = op == DIHEDRAL_IDENTITY ? *image
+                                                                  : *new_image;
+                if (!simd_chosen) {
+                        Simdtile_limit(SIMDTILE_AVX2);
+                }
+                Resample_filter turn_filter = filter == RESAMPLE_NEAREST
+                                              ? filter : RESAMPLE_BILINEAR;
+                rotate_image(new_image, &unturned, angle, turn_filter, 
+                             &background, methods);
+                if (op != DIHEDRAL_IDENTITY && !shared) {
+                        methods->free(&unturned.pixels);
+                }
+                shared = false;
+        }
+
+        /* 
+         * -scale resizes the turned image last, so its size is that of the
+         * image written; a side given as 0 keeps the aspect ratio
+         */
+        if (scaling) {
+                struct Pnm_ppm unscaled = turned ? *new_image : *image;
+                int width = scale[0];
+                int height = scale[1];
+                if (width == 0) {
+                        width = (int)((double)height * unscaled.width / 
+                                      unscaled.height + 0.5);
+                } else if (height == 0) {
+                        height = (int)((double)width * unscaled.height / 
+                                       unscaled.width + 0.5);
+                }
+                if (!simd_chosen) {
+                        Simdtile_limit(SIMDTILE_AVX2);
+                }
+                scale_image(new_image, &unscaled, width > 0 ? width : 1, 
+                            height > 0 ? height : 1, filter, methods);
+                if (turned && !shared) {
+                        methods->free(&unscaled.pixels);
+                }
+                shared = false;
+        }
+
+        /* brings the transformed image back to the layout it is written from */
+        if (changed && io_methods != methods) {
+                A2Methods_UArray2 out = A2convert_new(io_methods, methods, 
+                                                      new_image->pixels);
+                if (!shared) {
+                        methods->free(&new_image->pixels);
+                }
+                shared = false;
+                new_image->pixels = out;
+                new_image->methods = io_methods;
+        }
+
+        /* 
+         * writes the transformed image to stdout; steps that compose to the
+         * identity leave the original to be written as it was read
+         */
+        long written = changed ? (long)new_image->width * new_image->height
+                               : (long)og_image->width * og_image->height;
+        if (!changed) {
                 Pnm_ppmwrite(stdout, og_image);
                 free(new_image);
+        } else if (shared) {
+                Pnm_ppmwrite(stdout, new_image);
+                free(new_image);
         } else {
                 Pnm_ppmwrite(stdout, new_image);
                 Pnm_ppmfree(&new_image);
         }
 
         if (time_file != NULL) {
-                stop_timer(timer, time_file, methods, og_image);
+                stop_timer(timer, time_file, image->methods, image, 
+                           in_place, written, threads);
+        }
+        if (image != og_image) {
+                methods->free(&converted.pixels);
         }
         
+        if (og_image->pixels != full_pixels) {     /* free the crop view */
+                io_methods->free(&og_image->pixels);
+                og_image->pixels = full_pixels;
+        }
         Pnm_ppmfree(&og_image);
         fclose(input_stream);
 
@@ -269,7 +755,9 @@ void transform_image(A2Methods_mapfun *map, Pnm_ppm new_image,
         assert(apply != NULL);
         A2Methods_UArray2 new_uarray2 = methods->new(width, height, 
                                                 sizeof(struct Pnm_rgb));
-        struct closure cl = {methods, new_uarray2};
+        struct closure cl = {methods, new_uarray2, 
+                             methods->width(og_image->pixels), 
+                             methods->height(og_image->pixels)};
         map(og_image->pixels, apply, &cl);
         new_image->width = width;
         new_image->height = height;
@@ -279,6 +767,321 @@ void transform_image(A2Methods_mapfun *map, Pnm_ppm new_image,
 }
 
 
+/**********transform_layout********
+ *
+ * Creates a new A2Methods_UArray2 to hold the transformed image and fills it
+ * with a kernel specialized for the transformation, or else with the methods
+ * suite's transform operation; either walks the original and new images in
+ * whichever order suits the layout instead of calling an apply function for
+ * each pixel. Initializes the elements of new_image with the new dimensions
+ * and pixels.
+ * Inputs:
+ *              Pnm_ppm new_image: The Pnm_ppm struct that will hold the 
+ *                      transformed image
+ *              Pnm_ppm og_image: The original image
+ *              Dihedral_op op: The transformation to perform
+ *              Kernel_fun *kernel: The kernel for op and the layout of 
+ *                      methods (see kernels.h), or NULL to use 
+ *                      methods->transform
+ *              A2Methods_T methods: The methods suite of the original image,
+ *                      which is also used for the new image
+ * Return: N/A (void function)
+ * Expects:
+ *      * kernel or methods->transform to be nonnull
+ * Notes:
+ *      * Checked runtime error if both are null
+ *      * The client must free the new image's pixels through the methods 
+ *        suite at some point
+ ************************/
+void transform_layout(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                      Kernel_fun *kernel, A2Methods_T methods)
+{
+        assert(kernel != NULL || methods->transform != NULL);
+        int width = methods->width(og_image->pixels);
+        int height = methods->height(og_image->pixels);
+        if (Dihedral_swaps(op)) {
+                int swap = width;
+                width = height;
+                height = swap;
+        }
+        A2Methods_UArray2 new_uarray2 = methods->new(width, height, 
+                                                sizeof(struct Pnm_rgb));
+        if (kernel != NULL) {
+                kernel(og_image->pixels, new_uarray2);
+        } else {
+                methods->transform(og_image->pixels, new_uarray2, op);
+        }
+        new_image->width = width;
+        new_image->height = height;
+        new_image->denominator = og_image->denominator;
+        new_image->pixels = new_uarray2;
+        new_image->methods = methods;
+}
+
+/**********transform_in_place********
+ *
+ * Performs a transformation on the original image's own pixels with the 
+ * methods suite's in place transform, and makes new_image describe the 
+ * result, so no second array is allocated
+ * Inputs:
+ *              Pnm_ppm new_image: The Pnm_ppm struct that will describe the 
+ *                      transformed image
+ *              Pnm_ppm og_image: The original image, whose pixels are 
+ *                      transformed
+ *              Dihedral_op op: The transformation
+ *              A2Methods_T methods: The methods suite of the original image
+ * Return: N/A (void function)
+ * Expects:
+ *      * methods->transform_in_place to be nonnull
+ *      * op to keep the dimensions, or the methods suite to be able to 
+ *        reshape the original image's pixels (see a2methods.h)
+ * Notes:
+ *      * Checked runtime error if either expectation is not met
+ *      * The original image's pixels may change shape; its width and height
+ *        are left as they were, and those of new_image are the new ones
+ *      * new_image shares its pixels with og_image afterwards: the client 
+ *        frees new_image itself (not with Pnm_ppmfree) and the pixels 
+ *        through og_image
+ ************************/
+void transform_in_place(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                        A2Methods_T methods)
+{
+        assert(methods->transform_in_place != NULL);
+        methods->transform_in_place(og_image->pixels, op);
+        *new_image = *og_image;
+        new_image->width = methods->width(og_image->pixels);
+        new_image->height = methods->height(og_image->pixels);
+}
+
+/**********rotate_image********
+ *
+ * Creates a new A2Methods_UArray2 large enough to hold the original image
+ * turned clockwise by an angle that need not be a right angle, and fills
+ * it by resampling the original image. Initializes new_image with the new
+ * dimensions and pixels.
+ * Inputs:
+ *              Pnm_ppm new_image: The Pnm_ppm struct that will describe the
+ *                      turned image
+ *              Pnm_ppm og_image: The image to turn
+ *              double degrees: The clockwise angle of the turn
+ *              Resample_filter filter: How each new pixel is interpolated
+ *                      from the pixels of the original image
+ *              const struct Pnm_rgb *background: The colour of the corners
+ *                      of the new image that the original does not cover
+ *              A2Methods_T methods: The methods suite of both images
+ * Return: N/A (void function)
+ * Expects:
+ *      * og_image to have a populated pixels element
+ *      * the background to be no brighter than og_image's denominator
+ * Notes:
+ *      * The client frees the new pixels, with Pnm_ppmfree or
+ *        methods->free
+ ************************/
+void rotate_image(Pnm_ppm new_image, Pnm_ppm og_image, double degrees,
+                  Resample_filter filter, const struct Pnm_rgb *background,
+                  A2Methods_T methods)
+{
+        int width, height;
+        Resample_rotated_size(og_image->width, og_image->height, degrees,
+                              &width, &height);
+        A2Methods_UArray2 pixels = methods->new(width, height,
+                                                sizeof(struct Pnm_rgb));
+        Resample_rotate(methods, pixels, methods, og_image->pixels, degrees,
+                        filter, background);
+        *new_image = *og_image;
+        new_image->width = width;
+        new_image->height = height;
+        new_image->pixels = pixels;
+}
+
+/**********scale_image********
+ *
+ * Creates a new A2Methods_UArray2 of the argued dimensions and fills it by
+ * resampling the original image to that size. Initializes new_image with 
+ * the new dimensions and pixels.
+ * Inputs:
+ *              Pnm_ppm new_image: The Pnm_ppm struct that will describe the
+ *                      scaled image
+ *              Pnm_ppm og_image: The image to scale
+ *              int width, height: The dimensions of the scaled image
+ *              Resample_filter filter: How each new pixel is made from the
+ *                      pixels of the original image
+ *              A2Methods_T methods: The methods suite of both images
+ * Return: N/A (void function)
+ * Expects:
+ *      * og_image to have a populated, nonempty pixels element
+ *      * width and height to be positive
+ * Notes:
+ *      * Checked runtime error if either expectation is not met
+ *      * The client frees the new pixels, with Pnm_ppmfree or
+ *        methods->free
+ ************************/
+void scale_image(Pnm_ppm new_image, Pnm_ppm og_image, int width, int height,
+                 Resample_filter filter, A2Methods_T methods)
+{
+        assert(width > 0 && height > 0);
+        A2Methods_UArray2 pixels = methods->new(width, height,
+                                                sizeof(struct Pnm_rgb));
+        Resample_scale(methods, pixels, methods, og_image->pixels, filter,
+                       og_image->denominator);
+        *new_image = *og_image;
+        new_image->width = width;
+        new_image->height = height;
+        new_image->pixels = pixels;
+}
+
+/**********crop_image********
+ *
+ * Narrows an image to a window of itself without copying any pixels: its 
+ * pixels are replaced by a view of the window and its dimensions by the 
+ * window's, so transforming the image transforms only the window
+ * Inputs:
+ *              Pnm_ppm image: The image to crop
+ *              const int crop[4]: The x, y, width and height of the window
+ *              A2Methods_T methods: The methods suite of the image
+ *              const char *progname: The program name, for error messages
+ * Return: N/A (void function)
+ * Expects:
+ *      * crop to hold nonnegative values
+ * Notes:
+ *      * Exits with an error message if the methods suite cannot make views
+ *        or the window does not fit inside the image
+ *      * The caller must keep the original pixels, free the view with 
+ *        methods->free and put the original pixels back before freeing the
+ *        image
+ ************************/
+void crop_image(Pnm_ppm image, const int crop[4], A2Methods_T methods, 
+                const char *progname)
+{
+        if (methods->view == NULL) {
+                fprintf(stderr, "%s: the %s layout does not support "
+                                "cropping\n", progname, 
+                                methods == uarray2_methods_morton ? "Morton"
+                                                                  : "chosen");
+                exit(1);
+        }
+        if ((unsigned)crop[0] + crop[2] > image->width || 
+            (unsigned)crop[1] + crop[3] > image->height) {
+                fprintf(stderr, "%s: crop window %d,%d,%d,%d does not fit in "
+                                "a %ux%u image\n", progname, crop[0], crop[1],
+                                crop[2], crop[3], image->width, image->height);
+                exit(1);
+        }
+        image->pixels = methods->view(image->pixels, crop[0], crop[1], 
+                                                        crop[2], crop[3]);
+        image->width = crop[2];
+        image->height = crop[3];
+}
+
+/**********copy_span********
+ *
+ * Copies the cells of span src, in order, to the cells of span dst. Each 
+ * cell is size bytes. Contiguous spans are copied with a single memcpy.
+ ************************/
+static void copy_span(const A2Methods_Span *dst, const A2Methods_Span *src, 
+                      int size)
+{
+        assert(dst->count == src->count);
+        if (dst->stride == size && src->stride == size) {
+                memcpy(dst->base, src->base, (size_t)src->count * size);
+                return;
+        }
+        char *out = dst->base;
+        const char *in = src->base;
+        for (int k = 0; k < src->count; k++) {
+                memcpy(out, in, size);
+                out += dst->stride;
+                in += src->stride;
+        }
+}
+
+/**********reverse_span********
+ *
+ * Copies the cells of span src, last to first, to the cells of span dst, 
+ * so the first cell of dst receives the last cell of src
+ ************************/
+static void reverse_span(const A2Methods_Span *dst, const A2Methods_Span *src,
+                         int size)
+{
+        assert(dst->count == src->count);
+        if (src->count == 0) {
+                return;
+        }
+        char *out = dst->base;
+        const char *in = (const char *)src->base + 
+                                (size_t)(src->count - 1) * src->stride;
+        if (size == sizeof(struct Pnm_rgb)) {
+                for (int k = 0; k < src->count; k++) {
+                        *(Pnm_rgb)out = *(const struct Pnm_rgb *)in;
+                        out += dst->stride;
+                        in -= src->stride;
+                }
+                return;
+        }
+        for (int k = 0; k < src->count; k++) {
+                memcpy(out, in, size);
+                out += dst->stride;
+                in -= src->stride;
+        }
+}
+
+/**********transform_rows********
+ *
+ * Performs a horizontal flip, vertical flip or 180 degree rotation one row 
+ * at a time, using the row spans of the methods suite instead of a call per
+ * pixel
+ * Inputs:
+ *              Pnm_ppm new_image: The Pnm_ppm struct that will hold the 
+ *                      transformed image
+ *              Pnm_ppm og_image: The original image
+ *              Dihedral_op op: DIHEDRAL_ROTATE_180, 
+ *                      DIHEDRAL_FLIP_HORIZONTAL or DIHEDRAL_FLIP_VERTICAL
+ *              A2Methods_T methods: The methods suite of the original image,
+ *                      which is also used for the new image
+ * Return: N/A (void function)
+ * Expects:
+ *      * methods->row_span to be nonnull
+ *      * op to be one of the three transformations above
+ * Notes:
+ *      * Each of these transformations keeps every row together: a vertical
+ *        flip copies row j to row height - j - 1 with memcpy, a horizontal
+ *        flip copies row j reversed into row j of the new image, and a 180
+ *        degree rotation copies it reversed into row height - j - 1
+ *      * The client must free the new image's pixels through the methods 
+ *        suite at some point
+ *      * Checked runtime error if either expectation above is not met
+ ************************/
+void transform_rows(Pnm_ppm new_image, Pnm_ppm og_image, Dihedral_op op,
+                    A2Methods_T methods)
+{
+        assert(methods->row_span != NULL);
+        assert(op == DIHEDRAL_ROTATE_180 || op == DIHEDRAL_FLIP_HORIZONTAL ||
+               op == DIHEDRAL_FLIP_VERTICAL);
+        int width = methods->width(og_image->pixels);
+        int height = methods->height(og_image->pixels);
+        int size = sizeof(struct Pnm_rgb);
+        A2Methods_UArray2 new_uarray2 = methods->new(width, height, size);
+
+        for (int row = 0; row < height; row++) {
+                A2Methods_Span src, dst;
+                int new_row = op == DIHEDRAL_FLIP_HORIZONTAL ? row 
+                                                     : height - row - 1;
+                methods->row_span(og_image->pixels, row, &src);
+                methods->row_span(new_uarray2, new_row, &dst);
+                if (op == DIHEDRAL_FLIP_VERTICAL) {
+                        copy_span(&dst, &src, size);
+                } else {
+                        reverse_span(&dst, &src, size);
+                }
+        }
+
+        new_image->width = width;
+        new_image->height = height;
+        new_image->denominator = og_image->denominator;
+        new_image->pixels = new_uarray2;
+        new_image->methods = methods;
+}
+
 /**************************************************
  *******  Transformation Apply Functions  *********
  **************************************************/
@@ -311,10 +1114,10 @@ void transform_image(A2Methods_mapfun *map, Pnm_ppm new_image,
 void rotate_ninety(int col, int row, A2Methods_UArray2 A2uarray2, void *elem, 
                                                                 void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, 
-                                methods->height(A2uarray2) - row - 1, col);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, closure->height - row - 1, col);
         *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
 }
 
 /**********rotate_one_eighty********
@@ -345,11 +1148,11 @@ void rotate_ninety(int col, int row, A2Methods_UArray2 A2uarray2, void *elem,
 void rotate_one_eighty(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, 
-                                methods->width(A2uarray2) - col - 1, 
-                                methods->height(A2uarray2) - row - 1);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, closure->width - col - 1, 
+                                        closure->height - row - 1);
         *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
 }
 
 /**********rotate_two_seventy********
@@ -380,10 +1183,10 @@ void rotate_one_eighty(int col, int row, A2Methods_UArray2 A2uarray2,
 void rotate_two_seventy(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, row, 
-                                        methods->width(A2uarray2) - col - 1);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, row, closure->width - col - 1);
         *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
 }
 
 /**********flip_horizontal********
@@ -416,10 +1219,10 @@ void rotate_two_seventy(int col, int row, A2Methods_UArray2 A2uarray2,
 void flip_horizontal(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, 
-                                methods->width(A2uarray2) - col - 1, row);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, closure->width - col - 1, row);
         *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
 }
 
 /**********flip_vertical********
@@ -451,10 +1254,10 @@ void flip_horizontal(int col, int row, A2Methods_UArray2 A2uarray2,
 void flip_vertical(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, col, 
-                                        methods->height(A2uarray2) - row - 1);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, col, closure->height - row - 1);
         *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
 }
 
 /**********transpose********
@@ -486,8 +1289,45 @@ void flip_vertical(int col, int row, A2Methods_UArray2 A2uarray2,
 void transpose(int col, int row, A2Methods_UArray2 A2uarray2, 
                                                         void *elem, void *cl)
 {
-        A2Methods_T methods = ((struct closure *)cl)->method_suite;
-        Pnm_rgb rgb = methods->at(((struct closure *)cl)->uarray2, row, col);
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, row, col);
+        *rgb = *(Pnm_rgb)elem;
+        (void) A2uarray2;
+}
+
+/**********antitranspose********
+ *
+ * Transposes each pixel in a given A2Methods_UArray2 across the UR-to-LL 
+ * axis, which a chain of steps such as a transpose and a half turn reduces
+ * to
+ * Inputs:
+ *              int col: the column value of the current position in the 
+ *                       A2Methods_UArray2 A2uarray2
+ *              int row: the row value of the current position in the 
+ *                       A2Methods_UArray2 A2uarray2
+ *              A2Methods_UArray2 A2uarray2: An A2Methods_UArray2 
+ *                        representing the image to be transposed
+ *              void *elem: A pointer to the element in the A2Methods_UArray2 
+ *                          at position (col, row)
+ *              void *cl: The closing argument of this apply function. In this
+ *                          case, this will be a closure struct instance, 
+ *                          containing the A2Methods_UArray2 instance holding
+ *                          the newly transposed image and the methods suite
+ *                          to be used throughout this function.
+ * Return: N/A 
+ * Expects:
+ *      None
+ * Notes:
+ *      This function is an apply function that will be passed into the map 
+ *      function specified by the command line, so that it is called on every
+ *      cell in the image
+ ************************/
+void antitranspose(int col, int row, A2Methods_UArray2 A2uarray2, 
+                                                        void *elem, void *cl)
+{
+        struct closure *closure = cl;
+        Pnm_rgb rgb = pixel_at(closure, closure->height - row - 1, 
+                                        closure->width - col - 1);
         *rgb = *(Pnm_rgb)elem;
         (void) A2uarray2;
 }
@@ -533,19 +1373,46 @@ CPUTime_T start_timer()
  *                                   image
  *              Pnm_ppm og_image: A Pnm_ppm struct that holds the original 
  *                                image
+ *              bool in_place: whether the image was transformed in place
+ *              long written: the number of pixels in the image written out
+ *              int threads: the thread count given with -threads, or 0
  * Return: N/A 
  * Expects:
  *      * width and height to be nonnegative
  *      * size to be positive
  *      * blocksize to be positive
  * Notes:
+ *      * For the blocked methods suite, the blocksize of the image's array
+ *      and where it was chosen from (override, environment or cache size) 
+ *      are also reported, noting when it was capped to fit a small image,
+ *      along with the micro-tile size when the image is tiled at two levels
+ *      * For the plain methods suite, the row pitch of the original image is
+ *      reported next to its row length, which shows whether the rows were
+ *      padded
+ *      * When the parallel maps were used (-threads), or the resampling 
+ *      ran on more than one thread, the wall-clock time they took is 
+ *      reported along with each thread's utilization: the share of that 
+ *      time it spent running tasks, the number of tasks (bands or blocks)
+ *      it ran and the number of times it stole work. The total time above
+ *      is CPU time, which sums over all the threads.
+ *      * When -hugepages was given, the bytes mapped for huge pages, the 
+ *      bytes the kernel accepted MADV_HUGEPAGE for and the kB actually backed
+ *      by huge pages (while the original image is still allocated) are also
+ *      reported
+ *      * The throughput is the pixels written per second of the total
+ *      time, so it counts the larger canvas of a turn that is not a right
+ *      angle
+ *      * The peak resident set size of the process so far is reported, and 
+ *      when the image was transformed in place (in_place), the bytes of the
+ *      second image that were never allocated; run with -no-inplace to see
+ *      the peak of the copying transformation
  *      * The time file that holds the data is closed after the data is written 
  *      to it
  *      * The timer (of type CPUTime_T) is freed in this function using 
  *      CPUTime_Free
  ************************/
 void stop_timer(CPUTime_T timer, FILE *time_file, A2Methods_T methods, 
-                                                        Pnm_ppm og_image)
+                Pnm_ppm og_image, bool in_place, long written, int threads)
 {
         double time = CPUTime_Stop(timer);
         fprintf(time_file, "It took: %lf nanoseconds in total\n", time);
@@ -554,6 +1421,62 @@ void stop_timer(CPUTime_T timer, FILE *time_file, A2Methods_T methods,
         fprintf(time_file, "Number of pixels: %i\n", num_pixels);
         double tpp = time / num_pixels;
         fprintf(time_file, "Time per pixel: %f nanoseconds\n", tpp);
+        fprintf(time_file, "Throughput: %.1f megapixels per second "
+                           "(%ld pixels written)\n", 
+                time > 0 ? written * 1e3 / time : 0.0, written);
+        if (methods == uarray2_methods_blocked) {
+                const char *why;
+                int chosen = UArray2b_auto_blocksize(sizeof(struct Pnm_rgb),
+                                                     &why);
+                int blocksize = methods->blocksize(og_image->pixels);
+                fprintf(time_file, "Blocksize: %d (from %s%s)\n", 
+                        blocksize, why, blocksize < chosen 
+                                        ? ", capped to the image" : "");
+                int microsize = UArray2b_microsize(og_image->pixels);
+                if (microsize != methods->blocksize(og_image->pixels)) {
+                        fprintf(time_file, "Micro-tile size: %d\n", 
+                                                                microsize);
+                }
+        }
+        if (methods == uarray2_methods_plain) {
+                fprintf(time_file, "Row pitch: %d bytes (%d bytes of "
+                                   "pixels)\n", 
+                        UArray2_pitch(og_image->pixels),
+                        methods->width(og_image->pixels) * 
+                                        methods->size(og_image->pixels));
+        }
+        int ran = Parmap_stats_threads();
+        if (ran > 1 || (threads > 0 && ran > 0)) {
+                double wall = Parmap_wall_ns();
+                fprintf(time_file, "Parallel map wall time: %.0f nanoseconds "
+                                   "on %d threads\n", wall, ran);
+                for (int t = 0; t < ran; t++) {
+                        double busy;
+                        long tasks, steals;
+                        Parmap_stats(t, &busy, &tasks, &steals);
+                        fprintf(time_file, "Thread %d: %.1f%% busy, %ld "
+                                           "tasks, %ld steals\n", t, 
+                                wall > 0 ? 100.0 * busy / wall : 0.0, 
+                                tasks, steals);
+                }
+        }
+        if (Pixmem_huge_requested() > 0) {
+                fprintf(time_file, "Huge pages: %zu bytes mapped, %zu bytes "
+                                   "advised, %ld kB resident\n", 
+                        Pixmem_huge_requested(), Pixmem_huge_advised(),
+                        Pixmem_huge_resident_kb());
+        }
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+                fprintf(time_file, "Peak memory: %ld kB resident\n", 
+                                                        usage.ru_maxrss);
+        }
+        if (in_place) {
+                fprintf(time_file, "Transformed in place: %zu bytes of "
+                                   "pixels not allocated\n", 
+                        (size_t)num_pixels * 
+                                        methods->size(og_image->pixels));
+        }
         fclose(time_file);
         CPUTime_Free(&timer);
 }
\ No newline at end of file
@@ -0,0 +1,1077 @@
+/*
+ *     resample.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of resampling Pnm_rgb images. A rotation
+ *              walks the destination in square tiles. Each tile turns its
+ *              corners back into the source to find the small window of
+ *              source pixels it needs, copies that window into three planes
+ *              of floats (background outside the image), interpolates its
+ *              rows from the planes, eight pixels at a time with AVX2
+ *              gathers when the machine has them, and stores the rows back
+ *              as Pnm_rgb cells. Rows of tiles are handed to Parmap_run.
+ *              A scale is two separable passes over strips of output rows:
+ *              the source rows a strip needs are filtered across into a
+ *              buffer that fits in the L2 cache, and the strip's rows are
+ *              filtered down from it. Strips are handed to Parmap_run.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <assert.h>
+#include "resample.h"
+#include "parmap.h"
+#include "simdtile.h"
+#include "cacheinfo.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RESAMPLE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef A2Methods_UArray2 A2;   /* private abbreviation */
+
+/* the side of the square tiles the destination is walked in, in pixels */
+#define TILE 32
+
+/*
+ * the most source pixels along a side of a tile's window: the centres of
+ * a tile's corners turn back to points at most (TILE - 1) * sqrt(2) apart,
+ * and the window adds a pixel for rounding on one side and two for the
+ * bilinear neighbours on the other
+ */
+#define WINDOW (TILE * 3 / 2 + 4)
+
+/* the floats a band's task works in: a window and a tile of three planes */
+#define BUFFER_FLOATS (3 * WINDOW * WINDOW + 3 * TILE * TILE)
+
+/*
+ * closure for a rotation: the arrays with their suites and dimensions, the
+ * cosine and sine of the angle, the filter, the background as floats and
+ * whether the rows are interpolated with AVX2
+ */
+struct rotation {
+        A2Methods_T to;
+        A2 dst;
+        A2Methods_T from;
+        A2 src;
+        int width, height;              /* of src */
+        int dst_width, dst_height;
+        double cos, sin;
+        Resample_filter filter;         /* nearest or bilinear */
+        float background[3];
+        bool avx2;
+};
+
+/*
+ * a window of source pixels in three planes of floats (red, green, blue),
+ * each width x height in row-major order; (0, 0) of the window is pixel
+ * (col, row) of the source, which may lie outside it. avx2 is set when
+ * lines of the source are converted into it with AVX2.
+ */
+struct window {
+        int col, row;
+        int width, height;
+        float *plane[3];
+        bool avx2;
+};
+
+/* closure for copying a part of the source into a window */
+struct gather {
+        struct window *window;
+        int col, row;                   /* of the part, in the window */
+};
+
+/* closure for storing a tile of interpolated planes into the destination */
+struct scatter {
+        float *const *plane;            /* three planes */
+        int pitch;                      /* floats from one row to the next */
+};
+
+/**********turn********
+ *
+ * Stores the cosine and sine of a clockwise turn of degrees, exactly when
+ * the turn is a right angle so that right angle turns move whole pixels
+ ************************/
+static void turn(double degrees, double *cosine, double *sine)
+{
+        double reduced = fmod(degrees, 360.0);
+        if (reduced < 0) {
+                reduced += 360.0;
+        }
+        if (reduced == 0.0 || reduced == 90.0 || reduced == 180.0 ||
+            reduced == 270.0) {
+                static const double cosines[] = { 1, 0, -1, 0 };
+                static const double sines[] = { 0, 1, 0, -1 };
+                int quarter = (int)(reduced / 90.0);
+                *cosine = cosines[quarter];
+                *sine = sines[quarter];
+                return;
+        }
+        double radians = reduced * (M_PI / 180.0);
+        *cosine = cos(radians);
+        *sine = sin(radians);
+}
+
+/**********source_of********
+ *
+ * Stores in *x and *y the point of the source, in pixel coordinates (the
+ * centre of pixel (i, j) is at (i, j)), that the centre of destination
+ * pixel (col, row) turns back to
+ ************************/
+static void source_of(const struct rotation *rt, int col, int row,
+                      double *x, double *y)
+{
+        double dx = col + 0.5 - rt->dst_width / 2.0;
+        double dy = row + 0.5 - rt->dst_height / 2.0;
+        *x = rt->width / 2.0 + dx * rt->cos + dy * rt->sin - 0.5;
+        *y = rt->height / 2.0 - dx * rt->sin + dy * rt->cos - 0.5;
+}
+
+/**********fill********
+ *
+ * Sets the first count floats of each of three planes to the background
+ ************************/
+static void fill(float *const plane[3], int count, const float background[3])
+{
+        for (int p = 0; p < 3; p++) {
+                for (int k = 0; k < count; k++) {
+                        plane[p][k] = background[p];
+                }
+        }
+}
+
+#ifdef RESAMPLE_X86
+
+#define AVX2 __attribute__((target("avx2")))
+
+/**********gather_avx2********
+ *
+ * Converts cells of a line of the source to floats in three planes eight
+ * at a time, gathering each channel of eight cells at once
+ * Return: the number of cells converted, a multiple of eight
+ ************************/
+AVX2 static int gather_avx2(float *const plane[3], const char *base,
+                            int stride, int count)
+{
+        const __m256i step = _mm256_mullo_epi32(_mm256_set1_epi32(stride),
+                                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        int k = 0;
+        for (; k + 8 <= count; k += 8) {
+                const int *cells = (const void *)(base + (size_t)k * stride);
+                for (int p = 0; p < 3; p++) {
+                        __m256i channel = _mm256_i32gather_epi32(cells + p,
+                                                                 step, 1);
+                        _mm256_storeu_ps(plane[p] + k,
+                                         _mm256_cvtepi32_ps(channel));
+                }
+        }
+        return k;
+}
+
+#endif /* RESAMPLE_X86 */
+
+/**********gather_line********
+ *
+ * Copies count cells of a line of the source, stepping stride bytes from
+ * base, to the planes of a window starting at float offset at
+ ************************/
+static void gather_line(const struct window *w, int at, const char *base,
+                        int stride, int count)
+{
+        float *red = w->plane[0] + at;
+        float *green = w->plane[1] + at;
+        float *blue = w->plane[2] + at;
+        int k = 0;
+#ifdef RESAMPLE_X86
+        if (w->avx2) {
+                float *const line[3] = { red, green, blue };
+                k = gather_avx2(line, base, stride, count);
+        }
+#endif
+        for (; k < count; k++) {
+                const struct Pnm_rgb *px = (const void *)(base +
+                                                (size_t)k * stride);
+                red[k] = px->red;
+                green[k] = px->green;
+                blue[k] = px->blue;
+        }
+}
+
+/**********gather_tile********
+ *
+ * Tile apply function for a view of the source: copies the tile into the
+ * window of the closure
+ ************************/
+static void gather_tile(A2 view, const A2Methods_Tile *tile, void *vcl)
+{
+        const struct gather *g = vcl;
+        (void)view;
+        for (int j = 0; j < tile->height; j++) {
+                int at = (g->row + tile->row + j) * g->window->width +
+                         g->col + tile->col;
+                gather_line(g->window, at, (char *)tile->base +
+                            (size_t)j * tile->row_stride, tile->col_stride,
+                            tile->width);
+        }
+}
+
+/**********read_window********
+ *
+ * Fills a window from src, an array of the suite from: the part of it
+ * inside src, the columns [c0, c1) of the rows [r0, r1), is copied and the
+ * rest is set to the background (which may be NULL if there is no rest).
+ * Rows are read through row spans when the suite has them, its tiles
+ * through a view when it has views, and single cells otherwise.
+ ************************/
+static void read_window(A2Methods_T from, A2 src, const float *background,
+                        struct window *w, int c0, int r0, int c1, int r1)
+{
+        if (c0 > w->col || r0 > w->row || c1 < w->col + w->width ||
+            r1 < w->row + w->height) {
+                assert(background != NULL);
+                fill(w->plane, w->width * w->height, background);
+        }
+        int col = c0 - w->col;
+        if (from->row_span != NULL) {
+                for (int j = r0; j < r1; j++) {
+                        A2Methods_Span span;
+                        from->row_span(src, j, &span);
+                        gather_line(w, (j - w->row) * w->width + col,
+                                    (char *)span.base +
+                                    (size_t)c0 * span.stride,
+                                    span.stride, c1 - c0);
+                }
+        } else if (from->view != NULL && from->map_blocks != NULL) {
+                A2 view = from->view(src, c0, r0, c1 - c0, r1 - r0);
+                struct gather g = { w, col, r0 - w->row };
+                from->map_blocks(view, gather_tile, &g);
+                from->free(&view);
+        } else {
+                for (int j = r0; j < r1; j++) {
+                        for (int i = c0; i < c1; i++) {
+                                gather_line(w, (j - w->row) * w->width +
+                                            i - w->col,
+                                            (char *)from->at(src, i, j),
+                                            0, 1);
+                        }
+                }
+        }
+}
+
+/**********scatter_line********
+ *
+ * Stores count pixels of a row of three planes, starting at float offset
+ * at, as cells stepping stride bytes from base, rounding to the nearest
+ * value
+ ************************/
+static void scatter_line(char *base, int stride, float *const plane[3],
+                         int at, int count)
+{
+        const float *red = plane[0] + at;
+        const float *green = plane[1] + at;
+        const float *blue = plane[2] + at;
+        for (int k = 0; k < count; k++) {
+                struct Pnm_rgb *px = (void *)(base + (size_t)k * stride);
+                px->red = (unsigned)(red[k] + 0.5f);
+                px->green = (unsigned)(green[k] + 0.5f);
+                px->blue = (unsigned)(blue[k] + 0.5f);
+        }
+}
+
+/**********scatter_tile********
+ *
+ * Tile apply function for a view of a destination tile: stores the part
+ * of the interpolated planes that the tile covers
+ ************************/
+static void scatter_tile(A2 view, const A2Methods_Tile *tile, void *vcl)
+{
+        const struct scatter *s = vcl;
+        (void)view;
+        for (int j = 0; j < tile->height; j++) {
+                scatter_line((char *)tile->base +
+                             (size_t)j * tile->row_stride, tile->col_stride,
+                             s->plane, (tile->row + j) * s->pitch + tile->col,
+                             tile->width);
+        }
+}
+
+/**********write_tile********
+ *
+ * Stores the width x height pixels of the planes, whose rows are pitch
+ * floats apart, in dst, an array of the suite to, with (col, row) at the
+ * top left, by row spans, a view or single cells as read_window reads
+ ************************/
+static void write_tile(A2Methods_T to, A2 dst, int col, int row,
+                       int width, int height, float *const plane[3],
+                       int pitch)
+{
+        if (to->row_span != NULL) {
+                for (int j = 0; j < height; j++) {
+                        A2Methods_Span span;
+                        to->row_span(dst, row + j, &span);
+                        scatter_line((char *)span.base +
+                                     (size_t)col * span.stride, span.stride,
+                                     plane, j * pitch, width);
+                }
+        } else if (to->view != NULL && to->map_blocks != NULL) {
+                A2 view = to->view(dst, col, row, width, height);
+                struct scatter s = { plane, pitch };
+                to->map_blocks(view, scatter_tile, &s);
+                to->free(&view);
+        } else {
+                for (int j = 0; j < height; j++) {
+                        for (int i = 0; i < width; i++) {
+                                scatter_line((char *)to->at(dst, col + i,
+                                                            row + j), 0,
+                                             plane, j * pitch + i, 1);
+                        }
+                }
+        }
+}
+
+/**********clamp********
+ *
+ * Returns n moved into [low, high]
+ ************************/
+static inline int clamp(int n, int low, int high)
+{
+        return n < low ? low : (n > high ? high : n);
+}
+
+/**********row_scalar********
+ *
+ * Interpolates pixels first to count - 1 of a row of the destination into
+ * the planes out, from the window w. Pixel k turns back to the point
+ * (x + k * dx, y + k * dy) of the window.
+ ************************/
+static void row_scalar(const struct window *w, Resample_filter filter,
+                       float x, float y, float dx, float dy, int first,
+                       int count, float *const out[3])
+{
+        for (int k = first; k < count; k++) {
+                float fx = x + (float)k * dx;
+                float fy = y + (float)k * dy;
+                if (filter == RESAMPLE_NEAREST) {
+                        int at = clamp((int)floorf(fy + 0.5f), 0,
+                                       w->height - 1) * w->width +
+                                 clamp((int)floorf(fx + 0.5f), 0,
+                                       w->width - 1);
+                        for (int p = 0; p < 3; p++) {
+                                out[p][k] = w->plane[p][at];
+                        }
+                        continue;
+                }
+                int ix = clamp((int)floorf(fx), 0, w->width - 2);
+                int iy = clamp((int)floorf(fy), 0, w->height - 2);
+                float tx = fminf(fmaxf(fx - (float)ix, 0.0f), 1.0f);
+                float ty = fminf(fmaxf(fy - (float)iy, 0.0f), 1.0f);
+                int at = iy * w->width + ix;
+                for (int p = 0; p < 3; p++) {
+                        const float *q = w->plane[p] + at;
+                        float top = q[0] + tx * (q[1] - q[0]);
+                        float bottom = q[w->width] +
+                                       tx * (q[w->width + 1] - q[w->width]);
+                        out[p][k] = top + ty * (bottom - top);
+                }
+        }
+}
+
+#ifdef RESAMPLE_X86
+
+/**********row_avx2********
+ *
+ * Interpolates the pixels of a row as row_scalar does, eight at a time,
+ * gathering the neighbours of eight points from each plane at once
+ * Return: the number of pixels interpolated, a multiple of eight;
+ *         row_scalar does the rest
+ ************************/
+AVX2 static int row_avx2(const struct window *w, Resample_filter filter,
+                         float x, float y, float dx, float dy, int count,
+                         float *const out[3])
+{
+        const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256 vx = _mm256_set1_ps(x), vy = _mm256_set1_ps(y);
+        const __m256 vdx = _mm256_set1_ps(dx), vdy = _mm256_set1_ps(dy);
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1);
+        const __m256 half = _mm256_set1_ps(0.5f);
+        const __m256i pitch = _mm256_set1_epi32(w->width);
+        const __m256i low = _mm256_setzero_si256();
+        const __m256i one_in = _mm256_set1_epi32(1);
+        int near = filter == RESAMPLE_NEAREST;
+        const __m256i last_col = _mm256_set1_epi32(w->width - 2 + near);
+        const __m256i last_row = _mm256_set1_epi32(w->height - 2 + near);
+
+        int k = 0;
+        for (; k + 8 <= count; k += 8) {
+                __m256 lane = _mm256_add_ps(_mm256_set1_ps((float)k), lanes);
+                __m256 fx = _mm256_add_ps(vx, _mm256_mul_ps(lane, vdx));
+                __m256 fy = _mm256_add_ps(vy, _mm256_mul_ps(lane, vdy));
+                if (near) {
+                        fx = _mm256_add_ps(fx, half);
+                        fy = _mm256_add_ps(fy, half);
+                }
+                __m256i ix = _mm256_cvttps_epi32(_mm256_floor_ps(fx));
+                __m256i iy = _mm256_cvttps_epi32(_mm256_floor_ps(fy));
+                ix = _mm256_min_epi32(_mm256_max_epi32(ix, low), last_col);
+                iy = _mm256_min_epi32(_mm256_max_epi32(iy, low), last_row);
+                __m256i at = _mm256_add_epi32(_mm256_mullo_epi32(iy, pitch),
+                                              ix);
+                if (near) {
+                        for (int p = 0; p < 3; p++) {
+                                _mm256_storeu_ps(out[p] + k,
+                                        _mm256_i32gather_ps(w->plane[p],
+                                                            at, 4));
+                        }
+                        continue;
+                }
+                __m256 tx = _mm256_sub_ps(fx, _mm256_cvtepi32_ps(ix));
+                __m256 ty = _mm256_sub_ps(fy, _mm256_cvtepi32_ps(iy));
+                tx = _mm256_min_ps(_mm256_max_ps(tx, zero), one);
+                ty = _mm256_min_ps(_mm256_max_ps(ty, zero), one);
+                __m256i right = _mm256_add_epi32(at, one_in);
+                __m256i below = _mm256_add_epi32(at, pitch);
+                __m256i corner = _mm256_add_epi32(below, one_in);
+                for (int p = 0; p < 3; p++) {
+                        const float *q = w->plane[p];
+                        __m256 q00 = _mm256_i32gather_ps(q, at, 4);
+                        __m256 q10 = _mm256_i32gather_ps(q, right, 4);
+                        __m256 q01 = _mm256_i32gather_ps(q, below, 4);
+                        __m256 q11 = _mm256_i32gather_ps(q, corner, 4);
+                        __m256 top = _mm256_add_ps(q00, _mm256_mul_ps(tx,
+                                                _mm256_sub_ps(q10, q00)));
+                        __m256 bottom = _mm256_add_ps(q01, _mm256_mul_ps(tx,
+                                                _mm256_sub_ps(q11, q01)));
+                        _mm256_storeu_ps(out[p] + k, _mm256_add_ps(top,
+                                _mm256_mul_ps(ty,
+                                              _mm256_sub_ps(bottom, top))));
+                }
+        }
+        return k;
+}
+
+#endif /* RESAMPLE_X86 */
+
+/**********rotate_tile********
+ *
+ * Fills the width x height tile of the destination whose top left pixel
+ * is (col, row), working in buffer (BUFFER_FLOATS floats)
+ ************************/
+static void rotate_tile(const struct rotation *rt, int col, int row,
+                        int width, int height, float *buffer)
+{
+        /* the window of the source the corners of the tile turn back to */
+        double min_x = INFINITY, max_x = -INFINITY;
+        double min_y = INFINITY, max_y = -INFINITY;
+        for (int corner = 0; corner < 4; corner++) {
+                double x, y;
+                source_of(rt, col + (corner & 1) * (width - 1),
+                          row + (corner >> 1) * (height - 1), &x, &y);
+                min_x = fmin(min_x, x);
+                max_x = fmax(max_x, x);
+                min_y = fmin(min_y, y);
+                max_y = fmax(max_y, y);
+        }
+        struct window w;
+        w.avx2 = rt->avx2;
+        w.col = (int)floor(min_x) - 1;
+        w.row = (int)floor(min_y) - 1;
+        w.width = (int)floor(max_x) + 3 - w.col;
+        w.height = (int)floor(max_y) + 3 - w.row;
+        assert(w.width <= WINDOW && w.height <= WINDOW);
+        float *out[3];
+        for (int p = 0; p < 3; p++) {
+                w.plane[p] = buffer + p * w.width * w.height;
+                out[p] = buffer + 3 * WINDOW * WINDOW + p * TILE * TILE;
+        }
+
+        int c0 = w.col > 0 ? w.col : 0;
+        int r0 = w.row > 0 ? w.row : 0;
+        int c1 = w.col + w.width < rt->width ? w.col + w.width : rt->width;
+        int r1 = w.row + w.height < rt->height ? w.row + w.height
+                                                : rt->height;
+        if (c0 >= c1 || r0 >= r1) {     /* the tile is all background */
+                fill(out, TILE * TILE, rt->background);
+                write_tile(rt->to, rt->dst, col, row, width, height, out,
+                           TILE);
+                return;
+        }
+        read_window(rt->from, rt->src, rt->background, &w, c0, r0, c1, r1);
+
+        float dx = (float)rt->cos, dy = (float)-rt->sin;
+        for (int j = 0; j < height; j++) {
+                double x, y;
+                source_of(rt, col, row + j, &x, &y);
+                float *const line[3] = { out[0] + j * TILE,
+                                         out[1] + j * TILE,
+                                         out[2] + j * TILE };
+                float fx = (float)(x - w.col), fy = (float)(y - w.row);
+                int done = 0;
+#ifdef RESAMPLE_X86
+                if (rt->avx2) {
+                        done = row_avx2(&w, rt->filter, fx, fy, dx, dy,
+                                        width, line);
+                }
+#endif
+                row_scalar(&w, rt->filter, fx, fy, dx, dy, done, width,
+                           line);
+        }
+        write_tile(rt->to, rt->dst, col, row, width, height, out, TILE);
+}
+
+/**********rotate_band********
+ *
+ * Parmap task that fills row index of tiles of the destination, left to
+ * right
+ ************************/
+static void rotate_band(int index, void *vcl)
+{
+        const struct rotation *rt = vcl;
+        float *buffer = malloc(BUFFER_FLOATS * sizeof(*buffer));
+        assert(buffer != NULL);
+        int row = index * TILE;
+        int height = rt->dst_height - row < TILE ? rt->dst_height - row
+                                                 : TILE;
+        for (int col = 0; col < rt->dst_width; col += TILE) {
+                int width = rt->dst_width - col < TILE ? rt->dst_width - col
+                                                       : TILE;
+                rotate_tile(rt, col, row, width, height, buffer);
+        }
+        free(buffer);
+}
+
+/* the number of lobes on each side of the centre of the Lanczos filter */
+#define LANCZOS_LOBES 3
+
+/* the outputs of a pass whose weights are stored together */
+#define GROUP 8
+
+/* the rows of a scale read from the source, or stored, at a time */
+#define SCALE_ROWS 8
+
+/* the bytes of a scale's strip when the size of the L2 cache is unknown */
+#define SCALE_BUDGET (256 * 1024)
+
+/*
+ * the weights of one pass of a scale along an axis of n pixels to m: 
+ * output o is the sum, over t < count, of the weight of tap t of o times
+ * input first[o] + t. The weights of each group of GROUP outputs are kept
+ * together tap by tap, so the weights of one tap for the whole group can
+ * be loaded at once, and the outputs are padded to a whole number of
+ * groups with zero weights.
+ */
+struct taps {
+        int count;
+        int *first;
+        float *weight;
+};
+
+/*
+ * closure for a scale: the arrays with their suites and dimensions, the
+ * taps of the horizontal (across) and vertical (down) passes, the largest
+ * value a channel may take, the output rows in each strip and the most
+ * source rows a strip needs, the floats between rows of a plane of the
+ * horizontal pass's output, and whether the passes use AVX2
+ */
+struct scale {
+        A2Methods_T to;
+        A2 dst;
+        A2Methods_T from;
+        A2 src;
+        int width, height;              /* of src */
+        int dst_width, dst_height;
+        struct taps across, down;
+        float maxval;
+        int strip;
+        int rows;
+        int pitch;
+        bool avx2;
+};
+
+/**********padded********
+ *
+ * Returns n rounded up to a whole number of groups
+ ************************/
+static inline int padded(int n)
+{
+        return (n + GROUP - 1) / GROUP * GROUP;
+}
+
+/**********tap_weights********
+ *
+ * Returns the weight of tap 0 of output o; that of tap t is GROUP * t
+ * floats further on
+ ************************/
+static inline float *tap_weights(const struct taps *tp, int o)
+{
+        return tp->weight + (size_t)(o / GROUP) * tp->count * GROUP +
+               o % GROUP;
+}
+
+/**********filter_weight********
+ *
+ * Returns the weight the bilinear (tent) or Lanczos filter gives an input
+ * whose centre is distance d, in input pixels at a scale of one, from the
+ * point being sampled
+ ************************/
+static double filter_weight(Resample_filter filter, double d)
+{
+        d = fabs(d);
+        if (filter == RESAMPLE_BILINEAR) {
+                return d < 1.0 ? 1.0 - d : 0.0;
+        }
+        assert(filter == RESAMPLE_LANCZOS);
+        if (d < 1e-9) {
+                return 1.0;
+        } else if (d >= LANCZOS_LOBES) {
+                return 0.0;
+        }
+        double x = M_PI * d;
+        return LANCZOS_LOBES * sin(x) * sin(x / LANCZOS_LOBES) / (x * x);
+}
+
+/**********make_taps********
+ *
+ * Returns the taps of a pass that scales an axis of n pixels to m pixels
+ * with filter
+ * Notes:
+ *      * Output o covers inputs [o * n / m, (o + 1) * n / m). The nearest
+ *        filter takes the input under the middle of that span, the box
+ *        filter averages the inputs the span covers, weighted by how much
+ *        of each it covers, and the bilinear and Lanczos filters are
+ *        centred on its middle and, when shrinking, widened by n / m so
+ *        every input counts
+ *      * Taps that fall off either end of the axis are folded onto the
+ *        end pixel, and each output's weights are scaled to sum to one
+ *      * The caller frees first and weight
+ ************************/
+static struct taps make_taps(int n, int m, Resample_filter filter)
+{
+        double ratio = (double)n / m;
+        double stretch = ratio > 1.0 ? ratio : 1.0;
+        double support;
+        switch (filter) {
+        case RESAMPLE_NEAREST:
+                support = 0.0;
+                break;
+        case RESAMPLE_BOX:
+                support = ratio / 2.0;
+                break;
+        case RESAMPLE_BILINEAR:
+                support = stretch;
+                break;
+        default:
+                support = LANCZOS_LOBES * stretch;
+                break;
+        }
+        struct taps tp;
+        tp.count = (int)ceil(2.0 * support) + 1;
+        if (filter == RESAMPLE_BOX && ratio == floor(ratio)) {
+                tp.count = (int)ratio;  /* the spans start on a pixel */
+        }
+        if (tp.count > n) {
+                tp.count = n;
+        }
+        tp.first = calloc(padded(m), sizeof(*tp.first));
+        tp.weight = calloc((size_t)padded(m) * tp.count,
+                           sizeof(*tp.weight));
+        assert(tp.first != NULL && tp.weight != NULL);
+
+        for (int o = 0; o < m; o++) {
+                double centre = (o + 0.5) * ratio;
+                int lo, hi;
+                if (filter == RESAMPLE_NEAREST) {
+                        lo = hi = (int)floor(centre);
+                } else {
+                        lo = (int)floor(centre - support);
+                        hi = (int)ceil(centre + support) - 1;
+                }
+                int first = clamp(lo, 0, n - tp.count);
+                float *weight = tap_weights(&tp, o);
+                double sum = 0.0;
+                for (int i = lo; i <= hi; i++) {
+                        double w = 1.0;
+                        if (filter == RESAMPLE_BOX) {
+                                double a = fmax(i, centre - support);
+                                double b = fmin(i + 1, centre + support);
+                                w = b > a ? b - a : 0.0;
+                        } else if (filter != RESAMPLE_NEAREST) {
+                                w = filter_weight(filter,
+                                                  (i + 0.5 - centre) / stretch);
+                        }
+                        int t = clamp(i, 0, n - 1) - first;
+                        assert(t >= 0 && t < tp.count);
+                        weight[t * GROUP] += (float)w;
+                        sum += w;
+                }
+                for (int t = 0; t < tp.count; t++) {
+                        weight[t * GROUP] = (float)(weight[t * GROUP] / sum);
+                }
+                tp.first[o] = first;
+        }
+        return tp;
+}
+
+/**********across_scalar********
+ *
+ * Scales a row of three planes of inputs, in, to a row of outputs, out,
+ * by the taps; outputs from first on are done
+ ************************/
+static void across_scalar(const struct taps *tp, float *const in[3],
+                          float *const out[3], int first, int count)
+{
+        for (int o = first; o < count; o++) {
+                const float *weight = tap_weights(tp, o);
+                for (int p = 0; p < 3; p++) {
+                        const float *x = in[p] + tp->first[o];
+                        float sum = 0.0f;
+                        for (int t = 0; t < tp->count; t++) {
+                                sum += weight[t * GROUP] * x[t];
+                        }
+                        out[p][o] = sum;
+                }
+        }
+}
+
+/**********down_scalar********
+ *
+ * Makes count outputs of a row from the rows of three planes of inputs
+ * that start at row rows apart (pitch floats between rows), by the taps of
+ * output row o, clamping each to [0, maxval]; outputs from first on are
+ * done
+ ************************/
+static void down_scalar(const struct taps *tp, int o, float *const in[3],
+                        int row, int pitch, float maxval,
+                        float *const out[3], int first, int count)
+{
+        const float *weight = tap_weights(tp, o);
+        for (int p = 0; p < 3; p++) {
+                float *sum = out[p];
+                for (int k = first; k < count; k++) {
+                        sum[k] = 0.0f;
+                }
+                for (int t = 0; t < tp->count; t++) {
+                        const float *x = in[p] + (size_t)(row + t) * pitch;
+                        float w = weight[t * GROUP];
+                        for (int k = first; k < count; k++) {
+                                sum[k] += w * x[k];
+                        }
+                }
+                for (int k = first; k < count; k++) {
+                        sum[k] = fminf(fmaxf(sum[k], 0.0f), maxval);
+                }
+        }
+}
+
+#ifdef RESAMPLE_X86
+
+/**********across_avx2********
+ *
+ * Scales a row as across_scalar does, a group of eight outputs at a time:
+ * each tap is a load of eight weights and a gather of eight inputs from
+ * each plane
+ * Return: the number of outputs done, count rounded up to a whole number
+ *         of groups (the padding outputs get zero weights)
+ ************************/
+AVX2 static int across_avx2(const struct taps *tp, float *const in[3],
+                            float *const out[3], int count)
+{
+        int o = 0;
+        for (; o < count; o += GROUP) {
+                __m256i at = _mm256_loadu_si256((const __m256i *)
+                                                (tp->first + o));
+                const float *weight = tap_weights(tp, o);
+                __m256 sum[3] = { _mm256_setzero_ps(), _mm256_setzero_ps(),
+                                  _mm256_setzero_ps() };
+                for (int t = 0; t < tp->count; t++) {
+                        __m256 w = _mm256_loadu_ps(weight + t * GROUP);
+                        for (int p = 0; p < 3; p++) {
+                                __m256 x = _mm256_i32gather_ps(in[p] + t,
+                                                               at, 4);
+                                sum[p] = _mm256_add_ps(sum[p],
+                                                       _mm256_mul_ps(w, x));
+                        }
+                }
+                for (int p = 0; p < 3; p++) {
+                        _mm256_storeu_ps(out[p] + o, sum[p]);
+                }
+        }
+        return o;
+}
+
+/**********down_avx2********
+ *
+ * Makes a row as down_scalar does, eight outputs at a time with a
+ * broadcast weight per tap
+ * Return: the number of outputs done, a multiple of eight
+ ************************/
+AVX2 static int down_avx2(const struct taps *tp, int o, float *const in[3],
+                          int row, int pitch, float maxval,
+                          float *const out[3], int count)
+{
+        const float *weight = tap_weights(tp, o);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 top = _mm256_set1_ps(maxval);
+        int k = 0;
+        for (; k + GROUP <= count; k += GROUP) {
+                for (int p = 0; p < 3; p++) {
+                        const float *x = in[p] + (size_t)row * pitch + k;
+                        __m256 sum = zero;
+                        for (int t = 0; t < tp->count; t++) {
+                                __m256 w = _mm256_set1_ps(weight[t * GROUP]);
+                                sum = _mm256_add_ps(sum, _mm256_mul_ps(w,
+                                        _mm256_loadu_ps(x +
+                                                        (size_t)t * pitch)));
+                        }
+                        sum = _mm256_min_ps(_mm256_max_ps(sum, zero), top);
+                        _mm256_storeu_ps(out[p] + k, sum);
+                }
+        }
+        return k;
+}
+
+#endif /* RESAMPLE_X86 */
+
+/**********scale_strip********
+ *
+ * Parmap task that fills strip index of output rows of a scale: the
+ * source rows the strip needs are read SCALE_ROWS at a time and scaled
+ * across into planes of floats, which then stay in the cache while the
+ * output rows are made from them down the columns and stored, again
+ * SCALE_ROWS at a time
+ ************************/
+static void scale_strip(int index, void *vcl)
+{
+        const struct scale *sc = vcl;
+        int y0 = index * sc->strip;
+        int y1 = y0 + sc->strip < sc->dst_height ? y0 + sc->strip
+                                                  : sc->dst_height;
+        int r0 = sc->down.first[y0];
+        int r1 = sc->down.first[y1 - 1] + sc->down.count;
+        assert(r1 - r0 <= sc->rows);
+
+        size_t lines = (size_t)SCALE_ROWS * sc->width;
+        size_t across = (size_t)sc->rows * sc->pitch;
+        size_t stored = (size_t)SCALE_ROWS * sc->pitch;
+        float *buffer = malloc(3 * (lines + across + stored) *
+                               sizeof(*buffer));
+        assert(buffer != NULL);
+        struct window source = { 0, 0, sc->width, 0, { NULL, NULL, NULL },
+                                 sc->avx2 };
+        float *scaled[3], *out[3];
+        for (int p = 0; p < 3; p++) {
+                source.plane[p] = buffer + p * lines;
+                scaled[p] = buffer + 3 * lines + p * across;
+                out[p] = buffer + 3 * (lines + across) + p * stored;
+        }
+
+        for (source.row = r0; source.row < r1; source.row += SCALE_ROWS) {
+                source.height = r1 - source.row < SCALE_ROWS
+                                ? r1 - source.row : SCALE_ROWS;
+                read_window(sc->from, sc->src, NULL, &source, 0, source.row,
+                            sc->width, source.row + source.height);
+                for (int j = 0; j < source.height; j++) {
+                        size_t from = (size_t)j * sc->width;
+                        size_t to = (size_t)(source.row + j - r0) *
+                                    sc->pitch;
+                        float *const in[3] = { source.plane[0] + from,
+                                               source.plane[1] + from,
+                                               source.plane[2] + from };
+                        float *const row[3] = { scaled[0] + to,
+                                                scaled[1] + to,
+                                                scaled[2] + to };
+                        int done = 0;
+#ifdef RESAMPLE_X86
+                        if (sc->avx2) {
+                                done = across_avx2(&sc->across, in, row,
+                                                   sc->dst_width);
+                        }
+#endif
+                        across_scalar(&sc->across, in, row, done,
+                                      sc->dst_width);
+                }
+        }
+        for (int y = y0; y < y1; y += SCALE_ROWS) {
+                int count = y1 - y < SCALE_ROWS ? y1 - y : SCALE_ROWS;
+                for (int j = 0; j < count; j++) {
+                        int row = sc->down.first[y + j] - r0;
+                        float *const line[3] = {
+                                out[0] + (size_t)j * sc->pitch,
+                                out[1] + (size_t)j * sc->pitch,
+                                out[2] + (size_t)j * sc->pitch };
+                        int done = 0;
+#ifdef RESAMPLE_X86
+                        if (sc->avx2) {
+                                done = down_avx2(&sc->down, y + j, scaled,
+                                                 row, sc->pitch, sc->maxval,
+                                                 line, sc->dst_width);
+                        }
+#endif
+                        down_scalar(&sc->down, y + j, scaled, row,
+                                    sc->pitch, sc->maxval, line, done,
+                                    sc->dst_width);
+                }
+                write_tile(sc->to, sc->dst, 0, y, sc->dst_width, count, out,
+                           sc->pitch);
+        }
+        free(buffer);
+}
+
+/**********Resample_rotated_size********
+ *
+ * Stores the size of the canvas that holds a width x height image turned
+ * clockwise by degrees
+ * Inputs:
+ *              int width, height: the size of the image
+ *              double degrees: the angle of the turn
+ *              int *rotated_width, *rotated_height: where the size goes
+ * Return: N/A
+ * Expects:
+ *      * width and height to be nonnegative and the pointers nonnull
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * A hair is taken off before rounding up, so a side that is a whole
+ *        number of pixels but for rounding error does not grow by one
+ ************************/
+void Resample_rotated_size(int width, int height, double degrees,
+                           int *rotated_width, int *rotated_height)
+{
+        assert(width >= 0 && height >= 0);
+        assert(rotated_width != NULL && rotated_height != NULL);
+        double c, s;
+        turn(degrees, &c, &s);
+        c = fabs(c);
+        s = fabs(s);
+        *rotated_width = (int)ceil(width * c + height * s - 1e-6);
+        *rotated_height = (int)ceil(width * s + height * c - 1e-6);
+}
+
+/**********Resample_rotate********
+ *
+ * Turns src clockwise by degrees into the centre of dst
+ * Inputs:
+ *              A2Methods_T to: the methods suite of dst
+ *              A2Methods_UArray2 dst: the array that receives the image
+ *              A2Methods_T from: the methods suite of src
+ *              A2Methods_UArray2 src: the image to turn
+ *              double degrees: the clockwise angle of the turn
+ *              Resample_filter filter: how pixels are interpolated
+ *              const struct Pnm_rgb *background: the colour of the parts
+ *                      of dst that src does not cover
+ * Return: N/A
+ * Expects:
+ *      * the pointers to be nonnull and the arrays distinct
+ *      * the cells of both arrays to be struct Pnm_rgb
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The pixel values are interpolated as floats, which hold every
+ *        value a Pnm_rgb channel of a ppm can have exactly
+ *      * The rows of a tile are interpolated with AVX2 when both the
+ *        machine and Simdtile_limit allow it
+ ************************/
+void Resample_rotate(A2Methods_T to, A2Methods_UArray2 dst,
+                     A2Methods_T from, A2Methods_UArray2 src,
+                     double degrees, Resample_filter filter,
+                     const struct Pnm_rgb *background)
+{
+        assert(to != NULL && from != NULL && background != NULL);
+        assert(dst != NULL && src != NULL && dst != src);
+        assert(to->size(dst) == sizeof(struct Pnm_rgb));
+        assert(from->size(src) == sizeof(struct Pnm_rgb));
+        assert(filter == RESAMPLE_NEAREST || filter == RESAMPLE_BILINEAR);
+
+        struct rotation rt = { to, dst, from, src, from->width(src),
+                               from->height(src), to->width(dst),
+                               to->height(dst), 0, 0, filter,
+                               { background->red, background->green,
+                                 background->blue }, false };
+        turn(degrees, &rt.cos, &rt.sin);
+#ifdef RESAMPLE_X86
+        rt.avx2 = Simdtile_allowed() == SIMDTILE_AVX2;
+#endif
+        if (rt.dst_width == 0 || rt.dst_height == 0) {
+                return;
+        }
+        Parmap_run((rt.dst_height + TILE - 1) / TILE, rotate_band, &rt);
+}
+
+/**********Resample_scale********
+ *
+ * Scales src to the size of dst
+ * Inputs:
+ *              A2Methods_T to: the methods suite of dst
+ *              A2Methods_UArray2 dst: the array that receives the image
+ *              A2Methods_T from: the methods suite of src
+ *              A2Methods_UArray2 src: the image to scale
+ *              Resample_filter filter: how pixels are interpolated
+ *              unsigned maxval: the largest value a channel may take
+ * Return: N/A
+ * Expects:
+ *      * the pointers to be nonnull and the arrays distinct
+ *      * the cells of both arrays to be struct Pnm_rgb
+ *      * src to have pixels if dst does
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * A strip is as many output rows as keep the source rows it needs,
+ *        scaled across, within half the L2 cache, so the intermediate
+ *        image is never written out to memory whole. It is never so short
+ *        that most of its source rows are shared with the next strip
+ *        (scaled across twice), even when the rows of a wide image then
+ *        overflow the budget.
+ *      * Both passes use AVX2 when the machine and Simdtile_limit allow it
+ ************************/
+void Resample_scale(A2Methods_T to, A2Methods_UArray2 dst,
+                    A2Methods_T from, A2Methods_UArray2 src,
+                    Resample_filter filter, unsigned maxval)
+{
+        assert(to != NULL && from != NULL);
+        assert(dst != NULL && src != NULL && dst != src);
+        assert(to->size(dst) == sizeof(struct Pnm_rgb));
+        assert(from->size(src) == sizeof(struct Pnm_rgb));
+        struct scale sc = { to, dst, from, src, from->width(src),
+                            from->height(src), to->width(dst),
+                            to->height(dst), { 0, NULL, NULL },
+                            { 0, NULL, NULL }, (float)maxval, 0, 0, 0,
+                            false };
+        if (sc.dst_width == 0 || sc.dst_height == 0) {
+                return;
+        }
+        assert(sc.width > 0 && sc.height > 0);
+#ifdef RESAMPLE_X86
+        sc.avx2 = Simdtile_allowed() == SIMDTILE_AVX2;
+#endif
+        sc.across = make_taps(sc.width, sc.dst_width, filter);
+        sc.down = make_taps(sc.height, sc.dst_height, filter);
+        sc.pitch = padded(sc.dst_width);
+
+        long budget = Cacheinfo_size(2) / 2;
+        if (budget <= 0) {
+                budget = SCALE_BUDGET;
+        }
+        long rows = budget / (3L * sc.pitch * sizeof(float));
+        double ratio = (double)sc.height / sc.dst_height;
+        long strip = (long)((rows - sc.down.count) / ratio);
+        long least = (long)ceil(sc.down.count / ratio);
+        if (strip < least) {
+                strip = least;
+        }
+        sc.strip = strip < 1 ? 1 : (strip > sc.dst_height ? sc.dst_height
+                                                          : (int)strip);
+        for (int y0 = 0; y0 < sc.dst_height; y0 += sc.strip) {
+                int y1 = y0 + sc.strip < sc.dst_height ? y0 + sc.strip
+                                                        : sc.dst_height;
+                int need = sc.down.first[y1 - 1] + sc.down.count -
+                           sc.down.first[y0];
+                if (need > sc.rows) {
+                        sc.rows = need;
+                }
+        }
+        Parmap_run((sc.dst_height + sc.strip - 1) / sc.strip, scale_strip,
+                   &sc);
+        free(sc.across.first);
+        free(sc.across.weight);
+        free(sc.down.first);
+        free(sc.down.weight);
+}
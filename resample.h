@@ -0,0 +1,77 @@
+/*
+ *     resample.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for resampling an image of Pnm_rgb pixels into a
+ *              new grid: rotation by any angle into a canvas large enough
+ *              to hold the turned image, with the uncovered corners filled
+ *              with a background colour, and scaling to any size. The
+ *              arrays may be of any A2Methods layout.
+ */
+
+#ifndef RESAMPLE_INCLUDED
+#define RESAMPLE_INCLUDED
+
+#include "a2methods.h"
+#include "pnm.h"
+
+/*
+ * how a pixel of the new grid is made from the pixels around its centre;
+ * a rotation takes only the first two
+ */
+typedef enum Resample_filter {
+        RESAMPLE_NEAREST,       /* the pixel whose centre is nearest */
+        RESAMPLE_BILINEAR,      /* the nearest, weighted by distance */
+        RESAMPLE_BOX,           /* the average of the pixels covered */
+        RESAMPLE_LANCZOS        /* a Lanczos window of three lobes */
+} Resample_filter;
+
+/*
+ * Stores in *width and *height the size of the smallest canvas that holds
+ * a width x height image turned clockwise by degrees. The size of a right
+ * angle turn is exact (a quarter turn swaps the dimensions). It is a
+ * checked runtime error for width or height to be negative or for a
+ * result pointer to be NULL.
+ */
+extern void Resample_rotated_size(int width, int height, double degrees,
+                                  int *rotated_width, int *rotated_height);
+
+/*
+ * Turns src, an array of the suite from, clockwise by degrees about its
+ * centre and stores the result, centred, in dst, an array of the suite to:
+ * every pixel of dst takes the value of src at the point its centre turns
+ * back to, found with filter, and the parts of dst that src does not
+ * cover get *background, blended with the image along its edges. Both
+ * arrays hold struct Pnm_rgb cells, must be distinct, and may have any
+ * dimensions (Resample_rotated_size gives the canvas that loses nothing).
+ * The work is split into bands of tiles of dst run on up to
+ * Parmap_threads() threads; each tile reads only the small window of src
+ * that it turns back to. It is a checked runtime error for any pointer to
+ * be NULL, for the arrays to be the same, for their cells not to be the
+ * size of a struct Pnm_rgb or for filter not to be RESAMPLE_NEAREST or
+ * RESAMPLE_BILINEAR.
+ */
+extern void Resample_rotate(A2Methods_T to, A2Methods_UArray2 dst,
+                            A2Methods_T from, A2Methods_UArray2 src,
+                            double degrees, Resample_filter filter,
+                            const struct Pnm_rgb *background);
+
+/*
+ * Scales src, an array of the suite from, to the dimensions of dst, an
+ * array of the suite to, with filter, keeping every channel within
+ * [0, maxval] (the Lanczos filter overshoots at sharp edges). The scale is
+ * done in a pass across the rows and a pass down the columns, over strips
+ * of dst small enough that the rows between the passes stay in the cache;
+ * the strips are run on up to Parmap_threads() threads. When shrinking,
+ * the bilinear and Lanczos filters widen to take in every source pixel,
+ * and the box filter averages exactly the pixels under each new one when
+ * the sizes divide evenly. It is a checked runtime error for any pointer
+ * to be NULL, for the arrays to be the same, for their cells not to be
+ * the size of a struct Pnm_rgb, or for src to be empty when dst is not.
+ */
+extern void Resample_scale(A2Methods_T to, A2Methods_UArray2 dst,
+                           A2Methods_T from, A2Methods_UArray2 src,
+                           Resample_filter filter, unsigned maxval);
+
+#endif
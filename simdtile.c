@@ -0,0 +1,324 @@
+/*
+ *     simdtile.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of the vector tile transposes. Each routine
+ *              loads whole lines of cells, rearranges them in registers with
+ *              unpack and shuffle instructions, and stores whole lines. The
+ *              SSE2 routines are always available on x86-64; the AVX2 ones
+ *              are compiled for that instruction set function by function
+ *              and chosen only when the processor reports it, so the
+ *              program as a whole still runs anywhere. Other machines get
+ *              no routines and fall back on the callers' scalar loops.
+ *              12-byte cells (Pnm_rgb) have only an SSE2 routine: it is
+ *              bound by its loads and stores, which wider vectors do not
+ *              reduce.
+ */
+
+#include <stddef.h>
+#include <assert.h>
+#include "simdtile.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SIMDTILE_X86 1
+#include <immintrin.h>
+#endif
+
+#define N SIMDTILE_SIDE
+
+static Simdtile_isa limit = SIMDTILE_AVX2;
+
+#ifdef SIMDTILE_X86
+
+/*
+ * A 12-byte cell is three 4-byte channels, which no vector lane divides
+ * evenly, so the 12-byte routine builds the lines of the result from 8-
+ * and 4-byte pieces of the cells instead of transposing whole vectors.
+ * LOAD4 and LOAD8 load a piece into the low end of a vector.
+ */
+#define LOAD4(p) _mm_loadu_si32(p)
+#define LOAD8(p) _mm_loadl_epi64((const __m128i *)(p))
+
+/*
+ * transposes the 4 x 4 matrix of 4-byte values in v[0..3] (in each lane,
+ * for 256-bit vectors); BITS is the width of the vectors
+ */
+#define TRANSPOSE4(W, BITS, v) do {                                     \
+        __m##BITS##d lo01 = _mm##W##_castps_pd(                         \
+                        _mm##W##_unpacklo_ps(v[0], v[1]));              \
+        __m##BITS##d lo23 = _mm##W##_castps_pd(                         \
+                        _mm##W##_unpacklo_ps(v[2], v[3]));              \
+        __m##BITS##d hi01 = _mm##W##_castps_pd(                         \
+                        _mm##W##_unpackhi_ps(v[0], v[1]));              \
+        __m##BITS##d hi23 = _mm##W##_castps_pd(                         \
+                        _mm##W##_unpackhi_ps(v[2], v[3]));              \
+        v[0] = _mm##W##_castpd_ps(_mm##W##_unpacklo_pd(lo01, lo23));    \
+        v[1] = _mm##W##_castpd_ps(_mm##W##_unpackhi_pd(lo01, lo23));    \
+        v[2] = _mm##W##_castpd_ps(_mm##W##_unpacklo_pd(hi01, hi23));    \
+        v[3] = _mm##W##_castpd_ps(_mm##W##_unpackhi_pd(hi01, hi23));    \
+} while (0)
+
+/*
+ * The 4-, 8- and 16-byte routines below work on square sub-tiles of as
+ * many cells as a vector holds, i0 and k0 being the first in line and the
+ * first out line of a sub-tile.
+ */
+
+/**********sse2_4********
+ *
+ * Transposes an 8 x 8 tile of 4-byte cells as four 4 x 4 sub-tiles
+ ************************/
+static void sse2_4(char *const out[N], const char *const in[N])
+{
+        for (int i0 = 0; i0 < N; i0 += 4) {
+                for (int k0 = 0; k0 < N; k0 += 4) {
+                        __m128 v[4];
+                        for (int i = 0; i < 4; i++) {
+                                v[i] = _mm_loadu_ps((const float *)
+                                                    (in[i0 + i] + 4 * k0));
+                        }
+                        TRANSPOSE4(, 128, v);
+                        for (int k = 0; k < 4; k++) {
+                                _mm_storeu_ps((float *)(out[k0 + k] + 4 * i0),
+                                              v[k]);
+                        }
+                }
+        }
+}
+
+/**********sse2_8********
+ *
+ * Transposes an 8 x 8 tile of 8-byte cells as sixteen 2 x 2 sub-tiles
+ ************************/
+static void sse2_8(char *const out[N], const char *const in[N])
+{
+        for (int i0 = 0; i0 < N; i0 += 2) {
+                for (int k0 = 0; k0 < N; k0 += 2) {
+                        __m128i a = _mm_loadu_si128((const __m128i *)
+                                                    (in[i0] + 8 * k0));
+                        __m128i b = _mm_loadu_si128((const __m128i *)
+                                                    (in[i0 + 1] + 8 * k0));
+                        _mm_storeu_si128((__m128i *)(out[k0] + 8 * i0),
+                                         _mm_unpacklo_epi64(a, b));
+                        _mm_storeu_si128((__m128i *)(out[k0 + 1] + 8 * i0),
+                                         _mm_unpackhi_epi64(a, b));
+                }
+        }
+}
+
+/**********sse2_12********
+ *
+ * Transposes an 8 x 8 tile of 12-byte cells. Four cells, one from each of
+ * four in lines, make three vectors of an out line,
+ *      [x0 y0 z0 x1]  [y1 z1 x2 y2]  [z2 x3 y3 z3]
+ * each of which is unpacked from two 8-byte pieces, or from one 8-byte
+ * piece and two 4-byte pieces, of the cells. Every cell is read once, as
+ * two loads, and every out line is written with whole vector stores.
+ ************************/
+static void sse2_12(char *const out[N], const char *const in[N])
+{
+        for (int k = 0; k < N; k++) {
+                for (int i = 0; i < N; i += 4) {
+                        const char *p0 = in[i] + 12 * k;
+                        const char *p1 = in[i + 1] + 12 * k;
+                        const char *p2 = in[i + 2] + 12 * k;
+                        const char *p3 = in[i + 3] + 12 * k;
+                        __m128i *o = (__m128i *)(out[k] + 12 * i);
+                        _mm_storeu_si128(o, _mm_unpacklo_epi64(LOAD8(p0),
+                                        _mm_unpacklo_epi32(LOAD4(p0 + 8),
+                                                           LOAD4(p1))));
+                        _mm_storeu_si128(o + 1, 
+                                         _mm_unpacklo_epi64(LOAD8(p1 + 4),
+                                                            LOAD8(p2)));
+                        _mm_storeu_si128(o + 2, _mm_unpacklo_epi64(
+                                        _mm_unpacklo_epi32(LOAD4(p2 + 8),
+                                                           LOAD4(p3)),
+                                        LOAD8(p3 + 4)));
+                }
+        }
+}
+
+/**********sse2_16********
+ *
+ * Transposes an 8 x 8 tile of 16-byte cells, one vector per cell
+ ************************/
+static void sse2_16(char *const out[N], const char *const in[N])
+{
+        for (int k = 0; k < N; k++) {
+                for (int i = 0; i < N; i++) {
+                        _mm_storeu_si128((__m128i *)(out[k] + 16 * i),
+                                         _mm_loadu_si128((const __m128i *)
+                                                         (in[i] + 16 * k)));
+                }
+        }
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+/**********avx2_4********
+ *
+ * Transposes an 8 x 8 tile of 4-byte cells: each lane is transposed as a
+ * 4 x 4 matrix, and the lanes are then exchanged across the two halves
+ ************************/
+AVX2 static void avx2_4(char *const out[N], const char *const in[N])
+{
+        __m256 v[N];
+        for (int i = 0; i < N; i++) {
+                v[i] = _mm256_loadu_ps((const float *)in[i]);
+        }
+        TRANSPOSE4(256, 256, v);
+        TRANSPOSE4(256, 256, (v + 4));
+        for (int k = 0; k < 4; k++) {
+                _mm256_storeu_ps((float *)out[k],
+                                 _mm256_permute2f128_ps(v[k], v[k + 4], 0x20));
+                _mm256_storeu_ps((float *)out[k + 4],
+                                 _mm256_permute2f128_ps(v[k], v[k + 4], 0x31));
+        }
+}
+
+/**********avx2_8********
+ *
+ * Transposes an 8 x 8 tile of 8-byte cells as four 4 x 4 sub-tiles
+ ************************/
+AVX2 static void avx2_8(char *const out[N], const char *const in[N])
+{
+        for (int i0 = 0; i0 < N; i0 += 4) {
+                for (int k0 = 0; k0 < N; k0 += 4) {
+                        __m256i v[4];
+                        for (int i = 0; i < 4; i++) {
+                                v[i] = _mm256_loadu_si256((const __m256i *)
+                                                (in[i0 + i] + 8 * k0));
+                        }
+                        __m256i lo01 = _mm256_unpacklo_epi64(v[0], v[1]);
+                        __m256i hi01 = _mm256_unpackhi_epi64(v[0], v[1]);
+                        __m256i lo23 = _mm256_unpacklo_epi64(v[2], v[3]);
+                        __m256i hi23 = _mm256_unpackhi_epi64(v[2], v[3]);
+                        v[0] = _mm256_permute2x128_si256(lo01, lo23, 0x20);
+                        v[1] = _mm256_permute2x128_si256(hi01, hi23, 0x20);
+                        v[2] = _mm256_permute2x128_si256(lo01, lo23, 0x31);
+                        v[3] = _mm256_permute2x128_si256(hi01, hi23, 0x31);
+                        for (int k = 0; k < 4; k++) {
+                                _mm256_storeu_si256((__m256i *)
+                                                (out[k0 + k] + 8 * i0), v[k]);
+                        }
+                }
+        }
+}
+
+/**********avx2_16********
+ *
+ * Transposes an 8 x 8 tile of 16-byte cells as sixteen 2 x 2 sub-tiles,
+ * exchanging the lanes of pairs of vectors
+ ************************/
+AVX2 static void avx2_16(char *const out[N], const char *const in[N])
+{
+        for (int i0 = 0; i0 < N; i0 += 2) {
+                for (int k0 = 0; k0 < N; k0 += 2) {
+                        __m256i a = _mm256_loadu_si256((const __m256i *)
+                                                (in[i0] + 16 * k0));
+                        __m256i b = _mm256_loadu_si256((const __m256i *)
+                                                (in[i0 + 1] + 16 * k0));
+                        _mm256_storeu_si256((__m256i *)
+                                        (out[k0] + 16 * i0),
+                                        _mm256_permute2x128_si256(a, b, 0x20));
+                        _mm256_storeu_si256((__m256i *)
+                                        (out[k0 + 1] + 16 * i0),
+                                        _mm256_permute2x128_si256(a, b, 0x31));
+                }
+        }
+}
+
+#endif /* SIMDTILE_X86 */
+
+/**********Simdtile_best********
+ *
+ * Returns the strongest instruction set the routines can use here
+ * Notes:
+ *      * The processor is asked once, with the compiler's cpuid builtins,
+ *        which also check that the operating system saves the AVX state
+ ************************/
+Simdtile_isa Simdtile_best(void)
+{
+#ifdef SIMDTILE_X86
+        static int best = -1;
+        if (best < 0) {
+                __builtin_cpu_init();
+                best = __builtin_cpu_supports("avx2") ? SIMDTILE_AVX2
+                                                      : SIMDTILE_SSE2;
+        }
+        return best;
+#else
+        return SIMDTILE_SCALAR;
+#endif
+}
+
+/**********Simdtile_limit********
+ *
+ * Caps the instruction set Simdtile_transpose chooses at isa
+ * Expects:
+ *      * isa to be one of the Simdtile_isa values
+ * Notes:
+ *      * Checked runtime error if isa is out of range
+ ************************/
+void Simdtile_limit(Simdtile_isa isa)
+{
+        assert(isa >= SIMDTILE_SCALAR && isa <= SIMDTILE_AVX2);
+        limit = isa;
+}
+
+/**********Simdtile_allowed********
+ *
+ * Returns the strongest instruction set under the cap that the machine
+ * supports, for vector code outside this module that follows the cap
+ ************************/
+Simdtile_isa Simdtile_allowed(void)
+{
+        Simdtile_isa isa = Simdtile_best();
+        return isa > limit ? limit : isa;
+}
+
+/**********Simdtile_isa_name********
+ *
+ * Returns "scalar", "sse2" or "avx2"
+ ************************/
+const char *Simdtile_isa_name(Simdtile_isa isa)
+{
+        static const char *const names[] = { "scalar", "sse2", "avx2" };
+        assert(isa >= SIMDTILE_SCALAR && isa <= SIMDTILE_AVX2);
+        return names[isa];
+}
+
+/**********Simdtile_transpose********
+ *
+ * Returns the routine for cells of size bytes under the strongest allowed
+ * instruction set, or NULL
+ * Inputs:
+ *              int size: the cell size in bytes
+ * Return: the routine, or NULL if size has none or only scalar code may
+ *         be used
+ ************************/
+Simdtile_fun *Simdtile_transpose(int size)
+{
+        Simdtile_isa isa = Simdtile_allowed();
+#ifdef SIMDTILE_X86
+        if (isa == SIMDTILE_AVX2) {
+                switch (size) {
+                case 4:  return avx2_4;
+                case 8:  return avx2_8;
+                case 12: return sse2_12;  /* nothing wider pays */
+                case 16: return avx2_16;
+                }
+        } else if (isa == SIMDTILE_SSE2) {
+                switch (size) {
+                case 4:  return sse2_4;
+                case 8:  return sse2_8;
+                case 12: return sse2_12;
+                case 16: return sse2_16;
+                }
+        }
+#else
+        (void)size;
+#endif
+        return NULL;
+}
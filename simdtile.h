@@ -0,0 +1,59 @@
+/*
+ *     simdtile.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for transposing small square tiles of cells with
+ *              the vector instructions of the machine the program runs on.
+ *              The transformation kernels in kernels.h hand their quarter
+ *              turns and transposes to these routines SIMDTILE_SIDE x
+ *              SIMDTILE_SIDE cells at a time.
+ */
+
+#ifndef SIMDTILE_INCLUDED
+#define SIMDTILE_INCLUDED
+
+/* the number of cells in a side of a tile */
+#define SIMDTILE_SIDE 8
+
+/*
+ * Copies cell k of the line in[i] to cell i of the line out[k], for every
+ * i and k below SIMDTILE_SIDE. Each line is SIMDTILE_SIDE contiguous cells
+ * of the routine's cell size, with no alignment required, and no out line
+ * may overlap an in line.
+ */
+typedef void Simdtile_fun(char *const out[SIMDTILE_SIDE],
+                          const char *const in[SIMDTILE_SIDE]);
+
+/* the instruction sets the routines are written for, weakest first */
+typedef enum Simdtile_isa {
+        SIMDTILE_SCALAR,
+        SIMDTILE_SSE2,
+        SIMDTILE_AVX2
+} Simdtile_isa;
+
+/*
+ * Simdtile_best returns the strongest instruction set both the compiler
+ * and the processor (asked once, at the first call) support.
+ * Simdtile_limit caps the instruction set Simdtile_transpose will choose,
+ * so the vector routines can be compared with each other and with the
+ * scalar code; the cap starts at SIMDTILE_AVX2. Simdtile_allowed returns
+ * the weaker of the cap and Simdtile_best, for other vector code that
+ * honours the same cap. Simdtile_isa_name returns the name of an
+ * instruction set for reports.
+ */
+extern Simdtile_isa Simdtile_best(void);
+extern void Simdtile_limit(Simdtile_isa isa);
+extern Simdtile_isa Simdtile_allowed(void);
+extern const char *Simdtile_isa_name(Simdtile_isa isa);
+
+/*
+ * Returns the vector transpose for cells of size bytes under the strongest
+ * instruction set allowed, or NULL if there is none (the cell size has no
+ * vector routine, or the cap or the machine rules them out), in which case
+ * the caller copies the cells with its own scalar loop. Cells of 4, 8, 12
+ * and 16 bytes have vector routines.
+ */
+extern Simdtile_fun *Simdtile_transpose(int size);
+
+#endif
@@ -8,20 +8,52 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include "uarray2.h"
-#include "uarray.h"
-#include "uarrayrep.h"
+#include "uarray2_impl.h"
+#include "pixmem.h"
+#include "parmap.h"
+#include "cacheinfo.h"
 
 #define T UArray2_T 
 
+#define CACHE_LINE 64
 
-struct T {
-        UArray_T uarray;
-        int width;
-        int height;
-        int size;
-};
+/*
+ * Rows whose length in bytes is a multiple of ALIAS_GRAIN start in at most
+ * 1/4 of the sets of a 4KB cache way (16 of 64), so walking down a column 
+ * keeps evicting the same few sets. 4096- and 8192-pixel rows of 12-byte 
+ * pixels are such rows.
+ */
+#define ALIAS_GRAIN 256
+
+/* 
+ * bands of rows or columns handed to each thread by the parallel maps; more
+ * bands than threads leaves work to steal when some bands run slowly
+ */
+#define BANDS_PER_THREAD 8
+
+static int padding = 1;
+
+/**********choose_pitch********
+ *
+ * Returns the row pitch, in bytes, for rows of width cells of size bytes: 
+ * the row length itself, or, if padding is enabled and the row length is a
+ * multiple of ALIAS_GRAIN, the row length plus one cache line. The padded 
+ * pitch is an odd number of cache lines, so consecutive rows start in 
+ * different cache sets.
+ ************************/
+static int choose_pitch(int width, int size)
+{
+        size_t row_bytes = (size_t)width * size;
+        assert(row_bytes + CACHE_LINE <= (size_t)INT_MAX);
+        if (!padding || row_bytes == 0 || row_bytes % ALIAS_GRAIN != 0) {
+                return row_bytes;
+        }
+        return row_bytes + CACHE_LINE;
+}
 
 /**********UArray2_new********
  *
@@ -42,8 +74,12 @@ struct T {
  * Notes:
  *      Checked runtime error if width or height is negative, or if size
  *      is nonpositive
- *      UArray2 can raise Mem_Failed if UArray2_new cannot allocate the memory
- *      requested
+ *      Checked runtime error if the memory requested cannot be allocated
+ *      The cells come from Pixmem_alloc, so they are zero-filled and are 
+ *      backed by huge pages when those have been enabled
+ *      Rows are padded when their length would alias in the cache (see 
+ *      UArray2_set_padding); the padding is never visible through UArray2_at
+ *      or the mapping functions
  ************************/
 T UArray2_new(int width, int height, int size)
 {
@@ -57,8 +93,67 @@ T UArray2_new(int width, int height, int size)
         uarray2->height = height;
         uarray2->size = size;
 
-        uarray2->uarray = UArray_new(width * height, size);
+        uarray2->pitch = choose_pitch(width, size);
+        uarray2->nbytes = (size_t)uarray2->pitch * height;
+        uarray2->elems = Pixmem_alloc(uarray2->nbytes, &uarray2->mapped);
+        uarray2->parent = NULL;
+        uarray2->external = 0;
+        uarray2->release = NULL;
+        uarray2->release_cl = NULL;
+
+        return uarray2;
+}
+
+/**********UArray2_wrap********
+ *
+ * Returns a new UArray2 whose cells are an existing buffer, such as an mmap'd
+ * raster or the output of a decoder, so that it can be used (for example 
+ * through the plain methods suite) without being copied
+ * Inputs:
+ *              void *elems: the buffer; cell (col, row) is at 
+ *                      (char *)elems + row * pitch + col * size
+ *              int width: the number of columns in the UArray2
+ *              int height: the number of rows in the UArray2
+ *              int size: the size (in bytes) of each element
+ *              int pitch: the number of bytes from the start of one row of 
+ *                      the buffer to the start of the next
+ *              void release: called as release(elems, cl) by UArray2_free to
+ *                      give the buffer back, or NULL to leave it alone
+ *              void *cl: A closure passed to release
+ * Return: A UArray2 over the buffer
+ * Expects:
+ *      * width and height to be nonnegative, size to be positive
+ *      * pitch to be at least width * size
+ *      * elems to be nonnull unless the UArray2 is empty
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The buffer must hold (height - 1) * pitch + width * size bytes and
+ *        must stay valid until the UArray2 is freed
+ *      * The cells keep whatever the buffer holds; nothing is zero-filled
+ *      * The client must free the UArray2 using UArray2_free
+ ************************/
+T UArray2_wrap(void *elems, int width, int height, int size, int pitch,
+               void release(void *elems, void *cl), void *cl)
+{
+        assert(width >= 0);
+        assert(height >= 0);
+        assert(size > 0);
+        assert(pitch >= 0 && (size_t)pitch >= (size_t)width * size);
+        assert(elems != NULL || width == 0 || height == 0);
+        T uarray2 = malloc(sizeof(*uarray2));
+        assert(uarray2 != NULL);
 
+        uarray2->elems = elems;
+        uarray2->width = width;
+        uarray2->height = height;
+        uarray2->size = size;
+        uarray2->pitch = pitch;
+        uarray2->nbytes = 0;
+        uarray2->mapped = 0;
+        uarray2->parent = NULL;
+        uarray2->external = 1;
+        uarray2->release = release;
+        uarray2->release_cl = cl;
         return uarray2;
 }
 
@@ -77,7 +172,6 @@ T UArray2_new(int width, int height, int size)
 int UArray2_width(T uarray2) 
 {
         assert(uarray2 != NULL);
-        assert(uarray2->uarray != NULL); 
         return uarray2->width;
 }
 
@@ -96,7 +190,6 @@ int UArray2_width(T uarray2)
 int UArray2_height(T uarray2)
 {
         assert(uarray2 != NULL);
-        assert(uarray2->uarray != NULL); 
         return uarray2->height;
 }
 
@@ -115,10 +208,81 @@ int UArray2_height(T uarray2)
 int UArray2_size (T uarray2) 
 {
         assert(uarray2 != NULL);
-        assert(uarray2->uarray != NULL); 
         return uarray2->size;
 }
 
+/**********UArray2_pitch********
+ *
+ * Returns the number of bytes from the start of one row of the UArray2 to 
+ * the start of the next
+ * Inputs:
+ *              T uarray2: A pointer to the UArray2 in which the pitch is to
+ *                         be retrieved
+ * Return: the row pitch, which is at least width * size
+ * Expects:
+ *      Pointer to UArray2 to be nonnull
+ * Notes:
+ *      Checked runtime error if UArray2 is null
+ ************************/
+int UArray2_pitch(T uarray2)
+{
+        assert(uarray2 != NULL);
+        return uarray2->pitch;
+}
+
+/**********UArray2_set_padding********
+ *
+ * Selects whether UArray2s created from now on may pad their rows
+ * Inputs:
+ *              int enabled: nonzero (the default) to pad rows whose length
+ *                           is a multiple of ALIAS_GRAIN bytes, zero to 
+ *                           always store rows back to back
+ * Return: N/A
+ ************************/
+void UArray2_set_padding(int enabled)
+{
+        padding = enabled != 0;
+}
+
+/**********UArray2_view********
+ *
+ * Returns a new UArray2 that is a window onto the cells of another, without
+ * copying them
+ * Inputs:
+ *              T uarray2: the UArray2 (or view) to look into
+ *              int col, int row: the cell of uarray2 that is the top left 
+ *                      cell of the view
+ *              int width, int height: the number of columns and rows of the
+ *                      view
+ * Return: A UArray2 whose cell (i, j) is cell (col + i, row + j) of uarray2
+ * Expects:
+ *      * uarray2 to be nonnull
+ *      * the window to lie inside uarray2: col, row, width and height are 
+ *        nonnegative, col + width <= its width and row + height <= its 
+ *        height
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * Every UArray2 function accepts a view. A view keeps the pitch of 
+ *        uarray2, so its rows are still contiguous and UArray2_row works.
+ *      * The client must free the view using UArray2_free, which leaves the
+ *        cells alone, and must not use it once uarray2 is freed
+ ************************/
+T UArray2_view(T uarray2, int col, int row, int width, int height)
+{
+        assert(uarray2 != NULL);
+        assert(col >= 0 && width >= 0 && col + width <= uarray2->width);
+        assert(row >= 0 && height >= 0 && row + height <= uarray2->height);
+        T view = malloc(sizeof(*view));
+        assert(view != NULL);
+        *view = *uarray2;
+        view->parent = uarray2->parent != NULL ? uarray2->parent : uarray2;
+        view->elems = uarray2->elems + (size_t)row * uarray2->pitch + 
+                                                (size_t)col * uarray2->size;
+        view->width = width;
+        view->height = height;
+        return view;
+}
+
 /**********UArray2_free********
  *
  * Deallocates and clears the *UArray2
@@ -133,8 +297,19 @@ int UArray2_size (T uarray2)
  ************************/
 void UArray2_free(T *uarray2)
 {
-        UArray_free(&((*uarray2)->uarray));
+        assert(uarray2 != NULL && *uarray2 != NULL);
+        T array = *uarray2;
+        if (array->parent != NULL) {
+                /* a view: the cells belong to its parent */
+        } else if (array->external) {
+                if (array->release != NULL) {
+                        array->release(array->elems, array->release_cl);
+                }
+        } else {
+                Pixmem_free(array->elems, array->nbytes, array->mapped);
+        }
         free(*uarray2);
+        *uarray2 = NULL;
 }
 
 /**********UArray2_at********
@@ -166,7 +341,34 @@ void *UArray2_at(T uarray2, int col, int row)
         assert(uarray2 != NULL);
         assert(row >= 0 && row < uarray2->height);
         assert(col >= 0 && col < uarray2->width);
-        return UArray_at(uarray2->uarray, row * uarray2->width + col);
+        return UArray2_at_unchecked(uarray2, col, row);
+}
+
+/**********UArray2_row********
+ *
+ * Returns a pointer to the first element of a row of the UArray2. The width
+ * elements of the row are contiguous, size bytes apart, so a whole row can be
+ * copied or scanned without a call per element.
+ * Inputs:
+ *              T uarray2: A pointer to the UArray2 holding the row
+ *              int row: The row index within the UArray2
+ * Return: A pointer to the element at (0, row)
+ * Expects:
+ *      * An existing UArray2 is entered in as the first parameter
+ *      * The row value is nonnegative and is less than the height of the 
+ *        UArray2
+ * Notes:
+ *      * Checked runtime error if:
+ *              * UArray2 is null 
+ *              * row value >= height or row value < 0
+ *      * Consecutive rows are UArray2_pitch bytes apart, which may be more 
+ *        than width * size
+ ************************/
+void *UArray2_row(T uarray2, int row)
+{
+        assert(uarray2 != NULL);
+        assert(row >= 0 && row < uarray2->height);
+        return uarray2->elems + (size_t)row * uarray2->pitch;
 }
 
 /**********UArray2_map_row_major********
@@ -206,7 +408,8 @@ void UArray2_map_row_major(T uarray2, void apply(int col, int row, T uarray2,
         assert(uarray2 != NULL);
         for (int r = 0; r < uarray2->height; r++) {
                 for (int c = 0; c < uarray2->width; c++) {
-                        apply(c, r, uarray2, UArray2_at(uarray2, c, r), cl);
+                        void *elem = UArray2_at_unchecked(uarray2, c, r);
+                        apply(c, r, uarray2, elem, cl);
                 }
         }
 }
@@ -247,10 +450,743 @@ void UArray2_map_col_major(T uarray2, void apply(int col, int row, T uarray2,
         assert(uarray2 != NULL);
         for (int c = 0; c < uarray2->width; c++) {
                 for (int r = 0; r < uarray2->height; r++) {
-                        apply(c, r, uarray2, UArray2_at(uarray2, c, r), cl);
+                        void *elem = UArray2_at_unchecked(uarray2, c, r);
+                        apply(c, r, uarray2, elem, cl);
+                }
+        }
+}
+
+/**********UArray2_map_rows********
+ *
+ * Calls an apply function once for each row of UArray2, from top to bottom,
+ * with the whole row at once
+ * Inputs:
+ *              T uarray2: A pointer to the UArray2 whose rows will be visited
+ *              void apply: The function that will be applied to each row
+ *                  int row: the current row index
+ *                  T uarray2: A pointer to the same UArray2 passed into the
+ *                             outside function
+ *                  void *row_base: A pointer to the cell at (0, row); the 
+ *                                  cells of the row follow it contiguously
+ *                  int width: the number of cells in the row
+ *                  void *cl: A closure passed in by the client to be used in 
+ *                            the apply function  
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ * Notes:
+ *      * Checked runtime error if the UArray2 is null
+ *      * apply is not called for an array with no columns
+ ************************/
+void UArray2_map_rows(T uarray2, void apply(int row, T uarray2, 
+                      void *row_base, int width, void *cl), void *cl)
+{
+        assert(uarray2 != NULL);
+        if (uarray2->width == 0) {
+                return;
+        }
+        for (int r = 0; r < uarray2->height; r++) {
+                apply(r, uarray2, uarray2->elems + (size_t)r * uarray2->pitch,
+                      uarray2->width, cl);
+        }
+}
+
+/*
+ * closure used by the parallel maps to carry the client's apply function
+ * and the number of bands the UArray2 is cut into
+ */
+struct band_walk {
+        T uarray2;
+        void (*apply)(int col, int row, T uarray2, void *elem, void *cl);
+        void *cl;
+        int nbands;
+};
+
+/**********count_bands********
+ *
+ * Returns the number of bands to cut lines lines into for a parallel map
+ ************************/
+static int count_bands(int lines)
+{
+        int nbands = Parmap_threads() * BANDS_PER_THREAD;
+        return lines < nbands ? lines : nbands;
+}
+
+/**********row_band********
+ *
+ * Parmap task that visits the rows of band index in row-major order
+ ************************/
+static void row_band(int index, void *vcl)
+{
+        struct band_walk *walk = vcl;
+        T uarray2 = walk->uarray2;
+        int first = (long)uarray2->height * index / walk->nbands;
+        int last = (long)uarray2->height * (index + 1) / walk->nbands;
+        for (int r = first; r < last; r++) {
+                char *elem = uarray2->elems + (size_t)r * uarray2->pitch;
+                for (int c = 0; c < uarray2->width; c++) {
+                        walk->apply(c, r, uarray2, elem, walk->cl);
+                        elem += uarray2->size;
+                }
+        }
+}
+
+/**********col_band********
+ *
+ * Parmap task that visits the columns of band index in column-major order
+ ************************/
+static void col_band(int index, void *vcl)
+{
+        struct band_walk *walk = vcl;
+        T uarray2 = walk->uarray2;
+        int first = (long)uarray2->width * index / walk->nbands;
+        int last = (long)uarray2->width * (index + 1) / walk->nbands;
+        for (int c = first; c < last; c++) {
+                char *elem = uarray2->elems + (size_t)c * uarray2->size;
+                for (int r = 0; r < uarray2->height; r++) {
+                        walk->apply(c, r, uarray2, elem, walk->cl);
+                        elem += uarray2->pitch;
+                }
+        }
+}
+
+/**********UArray2_par_map_row_major********
+ *
+ * Calls an apply function for each element in UArray2 using several 
+ * threads. The rows are cut into bands that Parmap_run shares out among its
+ * threads, and each band is visited in row-major order.
+ * Inputs:
+ *              T uarray2: A pointer to the UArray2 that the apply function 
+ *                         will be called on 
+ *              void apply: The function that will be applied to each element
+ *                          (see UArray2_map_row_major)
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ *      * apply to be safe to call from several threads at once for 
+ *        different elements
+ * Notes:
+ *      * Checked runtime error if UArray2 is null
+ *      * Elements are visited in no particular order overall
+ ************************/
+void UArray2_par_map_row_major(T uarray2, void apply(int col, int row, 
+                                T uarray2, void *element_at, void *cl), 
+                                void *cl)
+{
+        assert(uarray2 != NULL);
+        if (uarray2->width == 0) {
+                return;
+        }
+        struct band_walk walk = { uarray2, apply, cl, 
+                                  count_bands(uarray2->height) };
+        Parmap_run(walk.nbands, row_band, &walk);
+}
+
+/**********UArray2_par_map_col_major********
+ *
+ * Calls an apply function for each element in UArray2 using several 
+ * threads. The columns are cut into bands that Parmap_run shares out among 
+ * its threads, and each band is visited in column-major order.
+ * Inputs:
+ *              T uarray2: A pointer to the UArray2 that the apply function 
+ *                         will be called on 
+ *              void apply: The function that will be applied to each element
+ *                          (see UArray2_map_col_major)
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2 to be nonnull
+ *      * apply to be safe to call from several threads at once for 
+ *        different elements
+ * Notes:
+ *      * Checked runtime error if UArray2 is null
+ *      * Elements are visited in no particular order overall
+ ************************/
+void UArray2_par_map_col_major(T uarray2, void apply(int col, int row, 
+                                T uarray2, void *element_at, void *cl), 
+                                void *cl)
+{
+        assert(uarray2 != NULL);
+        if (uarray2->height == 0) {
+                return;
+        }
+        struct band_walk walk = { uarray2, apply, cl, 
+                                  count_bands(uarray2->width) };
+        Parmap_run(walk.nbands, col_band, &walk);
+}
+
+/*
+ * Relative costs UArray2_transform uses to choose its loop order. A cache 
+ * line that is written costs WRITE_WEIGHT times one that is only read, as it
+ * is fetched (write-allocate) and later written back, and a line found in 
+ * the L2 cache costs L2_WEIGHT of one fetched from memory.
+ */
+#define WRITE_WEIGHT 2.0
+#define L2_WEIGHT 0.25
+
+/**********line_cost********
+ *
+ * Returns the estimated cost per cell, in cache lines fetched from memory, 
+ * of reaching cells of size bytes step bytes apart while the other array is
+ * walked along rows of lines cells. Cells reached in order (forwards or 
+ * backwards) share their lines. Cells reached down a column each start a 
+ * line, which the next rows of the walk reuse only if the lines of a whole
+ * row of the walk stay in the cache.
+ ************************/
+static double line_cost(long step, int size, int lines)
+{
+        double shared = (double)size / CACHE_LINE;
+        if (step == size || step == -size) {
+                return shared;
+        }
+        long bytes = (long)lines * CACHE_LINE;
+        if (bytes <= Cacheinfo_size(1)) {
+                return shared;
+        } else if (bytes <= Cacheinfo_size(2)) {
+                return shared + L2_WEIGHT;
+        }
+        return shared > 1.0 ? shared : 1.0;
+}
+
+/**********copy_cells********
+ *
+ * Copies width x height cells of size bytes. Cell (c, r) of the walk is 
+ * read at from + c * from_col + r * from_row and written at 
+ * to + c * to_col + r * to_row. Rows that are contiguous on both sides are
+ * copied with a single memcpy.
+ ************************/
+static void copy_cells(char *to, long to_col, long to_row, const char *from,
+                       long from_col, long from_row, int width, int height, 
+                       int size)
+{
+        for (int r = 0; r < height; r++) {
+                char *out = to + r * to_row;
+                const char *in = from + r * from_row;
+                if (to_col == size && from_col == size) {
+                        memcpy(out, in, (size_t)width * size);
+                        continue;
+                }
+                for (int c = 0; c < width; c++) {
+                        memcpy(out, in, size);
+                        out += to_col;
+                        in += from_col;
+                }
+        }
+}
+
+/**********UArray2_transform********
+ *
+ * Copies every cell of one UArray2 to its place in another under one of the
+ * eight symmetries of a rectangle, in the loop order that suits both arrays
+ * Inputs:
+ *              T src: the UArray2 to transform
+ *              T dst: the UArray2 that receives the transformed cells
+ *              Dihedral_op op: where each cell goes (see dihedral.h)
+ * Return: N/A
+ * Expects:
+ *      * src and dst to be nonnull, distinct and to have the same cell size
+ *      * dst to be src->height x src->width if op swaps the dimensions, and 
+ *        src->width x src->height otherwise
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * One array is walked row by row and the other is reached through the
+ *        affine form of op, so no coordinates are worked out per cell. Either
+ *        src is walked and its cells scattered into dst, or dst is walked and
+ *        its cells gathered from src; the order with the lower estimated 
+ *        cost (see line_cost) wins, and ties go to the gather, which writes 
+ *        in order. Flips and the half turn keep rows together, so they gather
+ *        rows that are read forwards or backwards; the quarter turns and the
+ *        transposes reach the other array down its columns, which the cost
+ *        model charges according to whether a row's worth of lines fits in 
+ *        the L1 or L2 cache.
+ *      * Either array may be a view or a wrapped buffer
+ ************************/
+void UArray2_transform(T src, T dst, Dihedral_op op)
+{
+        assert(src != NULL && dst != NULL && src != dst);
+        assert(src->size == dst->size);
+        assert(Dihedral_swaps(op) 
+                ? dst->width == src->height && dst->height == src->width
+                : dst->width == src->width && dst->height == src->height);
+        if (src->width == 0 || src->height == 0) {
+                return;
+        }
+
+        int size = src->size;
+        Dihedral_steps to = Dihedral_steps_of(op, src->width, src->height);
+        long to_col = (long)to.dcol_col * size + (long)to.drow_col * dst->pitch;
+        long to_row = (long)to.dcol_row * size + (long)to.drow_row * dst->pitch;
+        Dihedral_steps from = Dihedral_steps_of(Dihedral_inverse(op), 
+                                                dst->width, dst->height);
+        long from_col = (long)from.dcol_col * size + 
+                                        (long)from.drow_col * src->pitch;
+        long from_row = (long)from.dcol_row * size + 
+                                        (long)from.drow_row * src->pitch;
+
+        double scatter = line_cost(size, size, 0) + 
+                         WRITE_WEIGHT * line_cost(to_col, size, src->width);
+        double gather = line_cost(from_col, size, dst->width) + 
+                        WRITE_WEIGHT * line_cost(size, size, 0);
+        if (gather <= scatter) {
+                copy_cells(dst->elems, size, dst->pitch, 
+                           UArray2_at_unchecked(src, from.col0, from.row0),
+                           from_col, from_row, dst->width, dst->height, size);
+        } else {
+                copy_cells(UArray2_at_unchecked(dst, to.col0, to.row0), 
+                           to_col, to_row, src->elems, size, src->pitch, 
+                           src->width, src->height, size);
+        }
+}
+
+/* 
+ * bytes moved at a time by swap_cells, through a buffer on the stack; the
+ * cells of a line are swapped in pieces of at most this many bytes
+ */
+#define SWAP_BYTES 4096
+
+/**********swap_cells********
+ *
+ * Exchanges count cells of size bytes at a, stepping a_step bytes, with 
+ * count cells at b, stepping b_step bytes. Lines contiguous on both sides
+ * are swapped SWAP_BYTES at a time through a bounce buffer; other lines are
+ * swapped cell by cell. Called with a constant size, the compiler turns the
+ * cell swaps into a few moves.
+ ************************/
+static inline void swap_cells(char *a, long a_step, char *b, long b_step, 
+                              int count, int size)
+{
+        char bounce[SWAP_BYTES];
+        if (a_step == size && b_step == size) {
+                size_t left = (size_t)count * size;
+                while (left > 0) {
+                        size_t n = left < SWAP_BYTES ? left : SWAP_BYTES;
+                        memcpy(bounce, a, n);
+                        memcpy(a, b, n);
+                        memcpy(b, bounce, n);
+                        a += n;
+                        b += n;
+                        left -= n;
+                }
+                return;
+        }
+        for (int k = 0; k < count; k++) {
+                if (size <= SWAP_BYTES) {
+                        memcpy(bounce, a, size);
+                        memcpy(a, b, size);
+                        memcpy(b, bounce, size);
+                } else {
+                        swap_cells(a, size, b, size, 1, size);
                 }
+                a += a_step;
+                b += b_step;
+        }
+}
+
+/**********swap_line********
+ *
+ * swap_cells, specialized for the common cell sizes (such as the 12 bytes
+ * of a Pnm_rgb)
+ ************************/
+static void swap_line(char *a, long a_step, char *b, long b_step, int count,
+                      int size)
+{
+        switch (size) {
+        case 4:
+                swap_cells(a, a_step, b, b_step, count, 4);
+                break;
+        case 8:
+                swap_cells(a, a_step, b, b_step, count, 8);
+                break;
+        case 12:
+                swap_cells(a, a_step, b, b_step, count, 12);
+                break;
+        case 16:
+                swap_cells(a, a_step, b, b_step, count, 16);
+                break;
+        default:
+                swap_cells(a, a_step, b, b_step, count, size);
+                break;
         }
 }
 
+/* 
+ * side, in cells, of the tiles a square UArray2 is transposed in: a tile 
+ * and its mirror image across the diagonal, of 12-byte cells, fill less 
+ * than the L1 cache
+ */
+#define TRANSPOSE_TILE 32
+
+/* 
+ * bounds on the number of columns moved together by the column passes of 
+ * a non-square transpose (see strip_width)
+ */
+#define MIN_STRIP 8
+#define MAX_STRIP 64
+
+/**********transpose_square********
+ *
+ * Transposes a square UArray2 (or view) in place by swapping each cell 
+ * above the diagonal with its mirror image below it, a TRANSPOSE_TILE x 
+ * TRANSPOSE_TILE tile at a time, so that each row of a tile is swapped with
+ * a column of its mirror tile while both are in the cache
+ ************************/
+static void transpose_square(T uarray2)
+{
+        int side = uarray2->width;
+        int size = uarray2->size;
+        for (int r0 = 0; r0 < side; r0 += TRANSPOSE_TILE) {
+                int r1 = r0 + TRANSPOSE_TILE < side ? r0 + TRANSPOSE_TILE 
+                                                    : side;
+                for (int c0 = r0; c0 < side; c0 += TRANSPOSE_TILE) {
+                        int c1 = c0 + TRANSPOSE_TILE < side ? 
+                                                c0 + TRANSPOSE_TILE : side;
+                        for (int r = r0; r < r1; r++) {
+                                int c = c0 > r + 1 ? c0 : r + 1;
+                                if (c >= c1) {
+                                        continue;
+                                }
+                                swap_line(UArray2_at_unchecked(uarray2, c, r),
+                                          size, 
+                                          UArray2_at_unchecked(uarray2, r, c),
+                                          uarray2->pitch, c1 - c, size);
+                        }
+                }
+        }
+}
 
+/**********gcd********
+ *
+ * Returns the greatest common divisor of two positive integers
+ ************************/
+static int gcd(int a, int b)
+{
+        while (b != 0) {
+                int r = a % b;
+                a = b;
+                b = r;
+        }
+        return a;
+}
 
+/**********strip_width********
+ *
+ * Returns the number of adjacent columns the column passes of a transpose
+ * of rows rows move together: as many as let the strip of the array and 
+ * the buffer it is gathered into share a quarter of the L2 cache, between
+ * MIN_STRIP and MAX_STRIP. Each row of a strip is then a run of cells 
+ * rather than one cell per cache line.
+ ************************/
+static int strip_width(int rows, int size)
+{
+        long strip = Cacheinfo_size(2) / 4 / 2 / ((long)rows * size);
+        if (strip < MIN_STRIP) {
+                return MIN_STRIP;
+        } else if (strip > MAX_STRIP) {
+                return MAX_STRIP;
+        }
+        return strip;
+}
+
+/*
+ * a dense m x n array of cells being transposed in place (see 
+ * transpose_dense): rows of n cells of size bytes stored back to back, with
+ * c = gcd(m, n) and b = n / c, and a buffer of strip columns of m rows or 
+ * of one row, whichever is larger
+ */
+struct transposition {
+        char *cells;
+        int m, n, size;
+        int c, b;
+        int strip;
+        char *buffer;
+};
+
+/**********rotate_columns********
+ *
+ * First pass of transpose_dense: moves the cell in row i of column j to row
+ * (i + j / b) mod m, a strip of columns at a time. Each row of the strip is
+ * gathered into the buffer from the rows above it and the buffer is then 
+ * copied back over the strip.
+ ************************/
+static inline void rotate_columns(struct transposition *t, int size)
+{
+        size_t row_bytes = (size_t)t->n * size;
+        for (int j0 = 0; j0 < t->n; j0 += t->strip) {
+                int cols = t->n - j0 < t->strip ? t->n - j0 : t->strip;
+                size_t run = (size_t)cols * size;
+                for (int i = 0; i < t->m; i++) {
+                        char *out = t->buffer + i * run;
+                        for (int j = j0; j < j0 + cols; j++) {
+                                int from = i - j / t->b;
+                                from += from < 0 ? t->m : 0;
+                                memcpy(out, t->cells + from * row_bytes + 
+                                                (size_t)j * size, size);
+                                out += size;
+                        }
+                }
+                for (int i = 0; i < t->m; i++) {
+                        memcpy(t->cells + i * row_bytes + (size_t)j0 * size,
+                               t->buffer + i * run, run);
+                }
+        }
+}
+
+/**********shuffle_rows********
+ *
+ * Second pass of transpose_dense: within row r, moves the cell in column j
+ * to column (j * m + i) mod n, where i = (r - j / b) mod m is the row the
+ * cell started in, by scattering the row into the buffer and copying it 
+ * back. The target column is stepped along with j rather than worked out
+ * with divisions.
+ ************************/
+static inline void shuffle_rows(struct transposition *t, int size)
+{
+        int n = t->n;
+        int m_mod_n = t->m % n;
+        size_t row_bytes = (size_t)n * size;
+        for (int r = 0; r < t->m; r++) {
+                char *row = t->cells + r * row_bytes;
+                int jm = 0;             /* j * m mod n */
+                int i_mod_n = 0;        /* i mod n */
+                for (int j = 0; j < n; j++) {
+                        if (j % t->b == 0) {
+                                int i = r - j / t->b;
+                                i += i < 0 ? t->m : 0;
+                                i_mod_n = i % n;
+                        }
+                        int q = jm + i_mod_n;
+                        q -= q >= n ? n : 0;
+                        memcpy(t->buffer + (size_t)q * size, 
+                               row + (size_t)j * size, size);
+                        jm += m_mod_n;
+                        jm -= jm >= n ? n : 0;
+                }
+                memcpy(row, t->buffer, row_bytes);
+        }
+}
+
+/**********shuffle_columns********
+ *
+ * Last pass of transpose_dense: within column q, fills row p with the cell
+ * in row (i + j / b) mod m, where j * m + i = p * n + q is where the cell 
+ * lies in the transposed array, a strip of columns at a time. Down a column
+ * i and j are stepped along with p.
+ ************************/
+static inline void shuffle_columns(struct transposition *t, int size)
+{
+        int m = t->m;
+        int j_step = t->n / m;
+        int i_step = t->n % m;
+        size_t row_bytes = (size_t)t->n * size;
+        for (int q0 = 0; q0 < t->n; q0 += t->strip) {
+                int cols = t->n - q0 < t->strip ? t->n - q0 : t->strip;
+                size_t run = (size_t)cols * size;
+                for (int q = q0; q < q0 + cols; q++) {
+                        int i = q % m;
+                        int j = q / m;
+                        int u = j / t->b;       /* j / b and j mod b */
+                        int v = j % t->b;
+                        char *out = t->buffer + (size_t)(q - q0) * size;
+                        for (int p = 0; p < m; p++) {
+                                int from = i + u;
+                                from -= from >= m ? m : 0;
+                                memcpy(out, t->cells + from * row_bytes + 
+                                                (size_t)q * size, size);
+                                out += run;
+                                i += i_step;
+                                v += j_step;
+                                if (i >= m) {
+                                        i -= m;
+                                        v++;
+                                }
+                                while (v >= t->b) {
+                                        v -= t->b;
+                                        u++;
+                                }
+                        }
+                }
+                for (int p = 0; p < m; p++) {
+                        memcpy(t->cells + p * row_bytes + (size_t)q0 * size,
+                               t->buffer + p * run, run);
+                }
+        }
+}
+
+/* the passes of transpose_dense, for cells of SIZE bytes */
+#define TRANSPOSE_PASSES(SIZE) do {                             \
+        if (t.c > 1) {                                          \
+                rotate_columns(&t, SIZE);                       \
+        }                                                       \
+        shuffle_rows(&t, SIZE);                                 \
+        shuffle_columns(&t, SIZE);                              \
+} while (0)
+
+/**********transpose_dense********
+ *
+ * Transposes m x n cells of size bytes, stored as m rows of n cells back to
+ * back, into n rows of m cells in the same storage
+ * Notes:
+ *      * The passes are specialized for the common cell sizes (such as the
+ *        12 bytes of a Pnm_rgb), so each cell is moved with a few moves
+ *        rather than a call to memcpy
+ *      * Follows the decomposition of Catanzaro, Keller and Garland ("A
+ *        Decomposition for In-place Matrix Transposition", PPoPP 2014): a
+ *        rotation of each column (skipped when m and n are coprime), a 
+ *        shuffle within each row and a shuffle within each column. Each 
+ *        pass reads and writes every cell once, through a buffer of a row 
+ *        or of a strip of columns, so the array is swept two or three times
+ *        in runs of cells instead of chasing the cycles of the permutation
+ *        one cache miss per cell.
+ *      * The buffer holds max(n, m * strip) cells, which is small next to 
+ *        the array
+ ************************/
+static void transpose_dense(char *cells, int m, int n, int size)
+{
+        struct transposition t = { cells, m, n, size, gcd(m, n), 0, 
+                                   strip_width(m, size), NULL };
+        t.b = n / t.c;
+        size_t columns = (size_t)m * t.strip;
+        t.buffer = malloc((columns > (size_t)n ? columns : (size_t)n) * size);
+        assert(t.buffer != NULL);
+
+        switch (size) {
+        case 4:
+                TRANSPOSE_PASSES(4);
+                break;
+        case 8:
+                TRANSPOSE_PASSES(8);
+                break;
+        case 12:
+                TRANSPOSE_PASSES(12);
+                break;
+        case 16:
+                TRANSPOSE_PASSES(16);
+                break;
+        default:
+                TRANSPOSE_PASSES(size);
+                break;
+        }
+        free(t.buffer);
+}
+
+/**********transpose_in_place********
+ *
+ * Transposes a UArray2 in place, swapping its width and height. A square
+ * UArray2 is transposed across its diagonal. Otherwise the rows are first
+ * packed back to back, the cells are transposed by transpose_dense, and 
+ * the new rows are spread back out to a padded pitch (see choose_pitch) 
+ * when the storage is the UArray2's own and has room for it.
+ ************************/
+static void transpose_in_place(T uarray2)
+{
+        int width = uarray2->width;
+        int height = uarray2->height;
+        int size = uarray2->size;
+        if (width == height) {
+                transpose_square(uarray2);
+                return;
+        }
+
+        size_t packed = (size_t)width * size;
+        if ((size_t)uarray2->pitch != packed) {
+                for (int r = 1; r < height; r++) {
+                        memmove(uarray2->elems + r * packed, 
+                                uarray2->elems + (size_t)r * uarray2->pitch,
+                                packed);
+                }
+        }
+        if (width > 0 && height > 0) {
+                transpose_dense(uarray2->elems, height, width, size);
+        }
+        uarray2->width = height;
+        uarray2->height = width;
+        uarray2->pitch = height * size;
+
+        int pitch = choose_pitch(height, size);
+        if (uarray2->external || pitch == uarray2->pitch || 
+            (size_t)pitch * width > uarray2->nbytes) {
+                return;
+        }
+        for (int r = width - 1; r > 0; r--) {
+                memmove(uarray2->elems + (size_t)r * pitch, 
+                        uarray2->elems + (size_t)r * uarray2->pitch, 
+                        uarray2->pitch);
+        }
+        uarray2->pitch = pitch;
+}
+
+/**********UArray2_transform_in_place********
+ *
+ * Moves every cell of a UArray2 to its place under one of the eight 
+ * symmetries of a rectangle without a second array, swapping its width and
+ * height if the op does
+ * Inputs:
+ *              T uarray2: the UArray2 to transform
+ *              Dihedral_op op: where each cell goes (see dihedral.h)
+ * Return: N/A
+ * Expects:
+ *      * uarray2 to be nonnull
+ *      * uarray2 to be square or not to be a view if op swaps the 
+ *        dimensions
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The flips and the half turn are their own inverses, so each cell 
+ *        trades places with the cell it is sent to. A vertical flip or a 
+ *        half turn swaps each row of the top half with its partner in the
+ *        bottom half (read backwards for the half turn, and the middle row
+ *        of an odd height with itself); a horizontal flip swaps the left 
+ *        half of each row with the right. Every cell is read and written 
+ *        once, in the order the rows are stored.
+ *      * The ops that swap the dimensions are done as a transpose (see 
+ *        transpose_in_place) followed by a flip or the half turn: a quarter
+ *        turn clockwise is a transpose and a horizontal flip, the other 
+ *        quarter turn a transpose and a vertical flip, and the 
+ *        antitranspose a transpose and a half turn
+ *      * Transposing a non-square UArray2 may change its pitch; a wrapped
+ *        buffer is left with its rows packed back to back
+ *      * uarray2 may be a view or a wrapped buffer
+ ************************/
+void UArray2_transform_in_place(T uarray2, Dihedral_op op)
+{
+        assert(uarray2 != NULL);
+        if (Dihedral_swaps(op)) {
+                assert(uarray2->width == uarray2->height || 
+                       uarray2->parent == NULL);
+                transpose_in_place(uarray2);
+                op = Dihedral_compose(DIHEDRAL_TRANSPOSE, op);
+        }
+        int width = uarray2->width;
+        int height = uarray2->height;
+        if (op == DIHEDRAL_IDENTITY || width == 0 || height == 0) {
+                return;
+        }
+
+        int size = uarray2->size;
+        Dihedral_steps to = Dihedral_steps_of(op, width, height);
+        long to_col = (long)to.dcol_col * size;
+        long to_row = (long)to.drow_row * uarray2->pitch;
+        char *partner = UArray2_at_unchecked(uarray2, to.col0, to.row0);
+
+        if (to.drow_row > 0) {          /* rows stay put: swap their halves */
+                for (int r = 0; r < height; r++) {
+                        swap_line(uarray2->elems + (size_t)r * uarray2->pitch,
+                                  size, partner + r * to_row, to_col, 
+                                  width / 2, size);
+                }
+                return;
+        }
+        for (int r = 0; r < height / 2; r++) {
+                swap_line(uarray2->elems + (size_t)r * uarray2->pitch, size, 
+                          partner + r * to_row, to_col, width, size);
+        }
+        if (height % 2 == 1 && to.dcol_col < 0) {
+                int r = height / 2;     /* the middle row is reversed */
+                swap_line(uarray2->elems + (size_t)r * uarray2->pitch, size, 
+                          partner + r * to_row, to_col, width / 2, size);
+        }
+}
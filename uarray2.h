@@ -9,21 +9,72 @@
 
 #ifndef UARRAY2_INCLUDED
 #define UARRAY2_INCLUDED
+#include "dihedral.h"
+
 #define T UArray2_T
 typedef struct T *T;
 
 
 extern T UArray2_new(int width, int height, int size);
+extern T UArray2_view(T uarray2, int col, int row, int width, int height);
+
+/* 
+ * new 2d array over a buffer the caller already holds, without copying it:
+ * cell (col, row) is at (char *)elems + row * pitch + col * size, so pitch
+ * (in bytes) must be at least width * size. UArray2_free calls 
+ * release(elems, cl) if release is not NULL, and otherwise leaves the 
+ * buffer alone.
+ */
+extern T UArray2_wrap(void *elems, int width, int height, int size, 
+                      int pitch, void release(void *elems, void *cl), 
+                      void *cl);
 extern void UArray2_free(T *uarray2);
 extern int UArray2_width(T uarray2);
 extern int UArray2_height(T uarray2);
 extern int UArray2_size (T uarray2);
+extern int UArray2_pitch(T uarray2);
+extern void UArray2_set_padding(int enabled);
 extern void *UArray2_at(T uarray2, int col, int row);
+extern void *UArray2_row(T uarray2, int row);
 extern void UArray2_map_row_major(T uarray2, void apply(int col, int row, 
                             T uarray2, void *element_at, void *cl), void *cl);
 extern void UArray2_map_col_major(T uarray2, void apply(int col, int row, 
                             T uarray2, void *element_at, void *cl), void *cl);
 
+/* 
+ * calls apply once per row, top to bottom, with a pointer to the row's 
+ * first cell and the number of cells in the row, which are contiguous
+ */
+extern void UArray2_map_rows(T uarray2, void apply(int row, T uarray2, 
+                             void *row_base, int width, void *cl), void *cl);
+
+/* 
+ * parallel maps: apply is called once for each element, from up to 
+ * Parmap_threads() threads at once, each working through bands of rows (or
+ * columns) in row-major (or column-major) order. apply must be safe to call
+ * concurrently for different elements.
+ */
+extern void UArray2_par_map_row_major(T uarray2, void apply(int col, int row, 
+                            T uarray2, void *element_at, void *cl), void *cl);
+extern void UArray2_par_map_col_major(T uarray2, void apply(int col, int row, 
+                            T uarray2, void *element_at, void *cl), void *cl);
+
+/* 
+ * copies each cell of src to its place in dst under op, which must be 
+ * distinct from src, have the same cell size and have src's dimensions 
+ * (swapped if Dihedral_swaps(op)). The loop order is chosen by a cost model
+ * to suit both arrays.
+ */
+extern void UArray2_transform(T src, T dst, Dihedral_op op);
+
+/* 
+ * moves each cell of uarray2 to its place under op without a second array.
+ * The flips and the half turn swap cells with their partners; the ops that
+ * swap the dimensions transpose uarray2 in place first, which swaps its 
+ * width and height (and may change its pitch) and needs uarray2 to be 
+ * square or not a view (checked runtime error otherwise).
+ */
+extern void UArray2_transform_in_place(T uarray2, Dihedral_op op);
 
 #undef T
 #endif
@@ -0,0 +1,70 @@
+/*
+ *     uarray2_impl.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Representation of 2D Unboxed Arrays, exposed so that hot 
+ *              loops can inline an unchecked accessor instead of calling 
+ *              UArray2_at in another translation unit. Clients that only 
+ *              need the interface should include uarray2.h instead.
+ */
+
+#ifndef UARRAY2_IMPL_INCLUDED
+#define UARRAY2_IMPL_INCLUDED
+
+#include <stddef.h>
+#include "uarray2.h"
+
+/*
+ * This is the struct definition of the UArray2_T instance
+ * Elements:
+ *      char *elems: the cells of the UArray2 in row-major order, obtained 
+ *              from Pixmem_alloc (so they may be backed by huge pages)
+ *      int width: the number of columns in the UArray2
+ *      int height: the number of rows in the UArray2
+ *      int size: The size, in bytes, of each UArray2 element
+ *      int pitch: the number of bytes from the start of one row to the start
+ *              of the next, which is at least width * size and may include
+ *              padding at the end of each row
+ *      size_t nbytes: the number of bytes of storage at elems
+ *      int mapped: how the storage was obtained, for Pixmem_free
+ *      struct UArray2_T *parent: for a view made by UArray2_view, the 
+ *              UArray2 that owns the storage (elems then points at the top
+ *              left cell of the window); NULL for a UArray2 that owns it
+ *      int external: 1 if elems is a buffer adopted by UArray2_wrap rather
+ *              than storage from Pixmem_alloc
+ *      void (*release)(void *elems, void *cl), void *release_cl: for an 
+ *              adopted buffer, the callback UArray2_free hands the buffer 
+ *              back to (with release_cl), or NULL if the caller keeps it
+ */
+struct UArray2_T {
+        char *elems;
+        int width;
+        int height;
+        int size;
+        int pitch;
+        size_t nbytes;
+        int mapped;
+        struct UArray2_T *parent;
+        int external;
+        void (*release)(void *elems, void *cl);
+        void *release_cl;
+};
+
+/**********UArray2_at_unchecked********
+ *
+ * Returns a pointer to the element at (col, row), like UArray2_at, but with
+ * no checks at all
+ * Expects:
+ *      * uarray2 to be nonnull
+ *      * 0 <= col < width and 0 <= row < height
+ * Notes:
+ *      Unchecked runtime error if any of the above is false
+ ************************/
+static inline void *UArray2_at_unchecked(UArray2_T uarray2, int col, int row)
+{
+        return uarray2->elems + (size_t)row * uarray2->pitch + 
+                                        (size_t)col * uarray2->size;
+}
+
+#endif
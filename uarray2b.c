@@ -8,14 +8,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <math.h>
-#include <uarray2.h>
-#include <uarray2b.h>
-#include <uarray.h>
+#include "uarray2b.h"
+#include "uarray2b_impl.h"
+#include "cacheinfo.h"
+#include "pixmem.h"
+#include "parmap.h"
 
 #define T UArray2b_T
 #define SIXTY_FOUR_KB 65536
+#define TARGET_CACHE_LEVEL 2
+
+/* blocksize set by UArray2b_set_blocksize; 0 when there is no override */
+static int blocksize_override = 0;
+
+/* nonzero when UArray2b_new_auto_block should tile at two levels */
+static int two_level = 0;
+
+/* order of the cells inside blocks made by UArray2b_new_auto_block */
+static UArray2b_order default_order = UARRAY2B_COL_MAJOR;
 
 /*********************************
  *******      NOTE      **********
@@ -25,27 +38,45 @@
 * to any function in this interface
 */
 
-/*
- * This is the struct definition of the UArray2b_T instance
- * Elements:
- *      UArray2_T uarray2: A UArray2_T holding elements that are each blocks. 
- *              These blocks are represented by UArray_T's, whose elements are
- *              each the elements stored by the overall UArray2b
- *      int width: the number of columns in the UArray2b
- *      int height: the number of rows in the UArray2b
- *      int size: The size, in bytes, of each UArray2b element
- *      int blocksize: The number of elements in a side of a block of the 
- *              UArray2b, thus each block (UArray_T) contains 
- *              blocksize * blocksize elements.
- *              
- */
-struct T {
-        UArray2_T uarray2;
-        int width;
-        int height;
-        int size;
-        int blocksize;
-};
+/**********floor_pow2********
+ *
+ * Returns the largest power of two that is at most n, or 1 if n < 1
+ ************************/
+static int floor_pow2(int n)
+{
+        int pow2 = 1;
+        while (pow2 <= n / 2) {
+                pow2 *= 2;
+        }
+        return pow2;
+}
+
+/**********exact_log2********
+ *
+ * Returns log2 of n if n is a power of two, and -1 otherwise
+ ************************/
+static int exact_log2(int n)
+{
+        if (n < 1 || floor_pow2(n) != n) {
+                return -1;
+        }
+        int log = 0;
+        while ((1 << log) < n) {
+                log++;
+        }
+        return log;
+}
+
+/**********block_at********
+ *
+ * Returns a pointer to the first byte of the block at (block_col, block_row)
+ * within the slab of the UArray2b
+ ************************/
+static inline char *block_at(T array2b, int block_col, int block_row)
+{
+        size_t index = (size_t)block_row * array2b->block_width + block_col;
+        return array2b->slab + index * array2b->block_bytes;
+}
 
 /**********UArray2b_new********
  *
@@ -72,22 +103,105 @@ struct T {
  *              * width or height is negative
  *              * size is nonpositive
  *              * blocksize is nonpositive
- *      UArray2b can raise Mem_Failed if UArray2b_new can't allocate the memory
- *      requested
+ *      Checked runtime error if the slab holding the blocks cannot be 
+ *      allocated
+ *      All blocks live in one zero-filled, cache-line-aligned slab, so the
+ *      whole UArray2b costs two allocations regardless of its size. The slab
+ *      comes from Pixmem_alloc, so it is backed by huge pages when those have
+ *      been enabled.
  *      The client must free heap allocated memory using UArray2b_free
  ************************/
 T UArray2b_new (int width, int height, int size, int blocksize)
+{
+        return UArray2b_new_tiled(width, height, size, blocksize, blocksize,
+                                                        UARRAY2B_COL_MAJOR);
+}
+
+/**********UArray2b_new_two_level********
+ *
+ * Allocates, initializes and returns a new blocked UArray2 with two levels of
+ * tiling: blocks of blocksize x blocksize cells (sized for the L2 cache) are
+ * each cut into micro-tiles of microsize x microsize cells (sized for the L1
+ * cache). UArray2b_map walks both levels, finishing a micro-tile before 
+ * starting the next and a block before starting the next.
+ * Inputs:
+ *              int width: integer storing the number of columns contained in 
+ *                         the UArray2b
+ *              int height: integer storing the number of rows contained in the
+ *                          UArray2b
+ *              int size: integer storing the size (in bytes) of each element
+ *                        in the new UArray2b
+ *              int blocksize: the number of cells in a side of a block
+ *              int microsize: the number of cells in a side of a micro-tile
+ * Return: A new UArray2b with width x height number of elements, each of which
+ *         are of size bytes
+ * Expects:
+ *      * width and height to be nonnegative
+ *      * size, blocksize and microsize to be positive
+ *      * microsize to divide blocksize
+ * Notes:
+ *      Checked runtime error if any expectation is not met, or if the slab 
+ *      holding the blocks cannot be allocated
+ *      A microsize equal to the blocksize gives a single level of blocking
+ *      The cells are stored in column-major order inside micro-tiles
+ *      The client must free heap allocated memory using UArray2b_free
+ ************************/
+T UArray2b_new_two_level(int width, int height, int size, int blocksize,
+                         int microsize)
+{
+        return UArray2b_new_tiled(width, height, size, blocksize, microsize,
+                                                        UARRAY2B_COL_MAJOR);
+}
+
+/**********UArray2b_new_tiled********
+ *
+ * Allocates, initializes and returns a new blocked UArray2 with the given 
+ * blocksize and microsize (see UArray2b_new_two_level) whose micro-tiles and
+ * cells are stored in the given order inside each block. Row-major order 
+ * makes each row of a micro-tile contiguous, so it can be copied straight to
+ * or from a scanline of a plain array; column-major order makes each column
+ * contiguous.
+ * Inputs:
+ *              int width: integer storing the number of columns contained in 
+ *                         the UArray2b
+ *              int height: integer storing the number of rows contained in the
+ *                          UArray2b
+ *              int size: integer storing the size (in bytes) of each element
+ *                        in the new UArray2b
+ *              int blocksize: the number of cells in a side of a block
+ *              int microsize: the number of cells in a side of a micro-tile
+ *              UArray2b_order order: UARRAY2B_ROW_MAJOR or UARRAY2B_COL_MAJOR
+ * Return: A new UArray2b with width x height number of elements, each of which
+ *         are of size bytes
+ * Expects:
+ *      * width and height to be nonnegative
+ *      * size, blocksize and microsize to be positive
+ *      * microsize to divide blocksize
+ *      * order to be one of the two UArray2b_order values
+ * Notes:
+ *      Checked runtime error if any expectation is not met, or if the slab 
+ *      holding the blocks cannot be allocated
+ *      The client must free heap allocated memory using UArray2b_free
+ ************************/
+T UArray2b_new_tiled(int width, int height, int size, int blocksize,
+                     int microsize, UArray2b_order order)
 {
         T uarray2b = malloc(sizeof(*uarray2b));
         assert(uarray2b != NULL);
         assert(width >= 0); 
         assert(height >= 0);
+        assert(size > 0);
         assert(blocksize >= 1);
+        assert(microsize >= 1 && blocksize % microsize == 0);
+        assert(order == UARRAY2B_COL_MAJOR || order == UARRAY2B_ROW_MAJOR);
 
+        uarray2b->order = order;
         uarray2b->width = width;
         uarray2b->height = height;
         uarray2b->size = size;
         uarray2b->blocksize = blocksize;
+        uarray2b->microsize = microsize;
+        uarray2b->micro_side = blocksize / microsize;
 
         int block_width = width / blocksize;
         int block_height = height / blocksize;
@@ -99,18 +213,26 @@ T UArray2b_new (int width, int height, int size, int blocksize)
                 block_height++;
         }
 
-        /* Instantiates UArray2 holding the blocks */
-        uarray2b->uarray2 = UArray2_new(block_width, block_height, 
-                                                        sizeof(UArray_T));
-
-        /* Instantiates each UArray representing blocks, holding elements */
-        for (int c = 0; c < block_width; c++) {
-                for (int r = 0; r < block_height; r++) {
-                        UArray_T *ua = UArray2_at(uarray2b->uarray2, c, r);
-                        *ua = UArray_new(blocksize * blocksize, size);
-                }
+        uarray2b->block_width = block_width;
+        uarray2b->block_height = block_height;
+        uarray2b->block_bytes = (size_t)blocksize * blocksize * size;
+        uarray2b->micro_bytes = (size_t)microsize * microsize * size;
+        uarray2b->log_blocksize = exact_log2(blocksize);
+        uarray2b->log_microsize = exact_log2(microsize);
+        if (uarray2b->log_blocksize < 0 || uarray2b->log_microsize < 0) {
+                uarray2b->log_blocksize = -1;
+                uarray2b->log_microsize = -1;
         }
 
+        /* Instantiates the slab holding every block */
+        uarray2b->slab_bytes = (size_t)block_width * block_height * 
+                                                        uarray2b->block_bytes;
+        uarray2b->slab = Pixmem_alloc(uarray2b->slab_bytes, 
+                                                        &uarray2b->mapped);
+        uarray2b->parent = NULL;
+        uarray2b->col0 = 0;
+        uarray2b->row0 = 0;
+
         return uarray2b;
 }
 
@@ -119,7 +241,8 @@ T UArray2b_new (int width, int height, int size, int blocksize)
  * Allocates, initializes and returns a new blocked UArray2 with width x height 
  * cells, each of which are of size bytes and have a blocksize as large as 
  * possible provided a block occupies at most 64KB. Blocksize is defaulted to
- * 1 if a single cell will not fit in 64KB.
+ * 1 if a single cell will not fit in 64KB. The blocksize is rounded down to a
+ * power of two so that UArray2b_at can index with shifts and masks.
  * Inputs:
  *              int width: integer storing the number of columns contained in 
  *                         the UArray2b
@@ -150,11 +273,251 @@ T UArray2b_new_64K_block(int width, int height, int size)
 {
         int blocksize = 1;
         if (!(size > SIXTY_FOUR_KB)) {
-                blocksize = sqrt(SIXTY_FOUR_KB / size);
+                blocksize = floor_pow2(sqrt(SIXTY_FOUR_KB / size));
         }
         return UArray2b_new(width, height, size, blocksize);
 }
 
+/**********UArray2b_auto_blocksize********
+ *
+ * Chooses the blocksize for a blocked array holding cells of size bytes. In
+ * order of preference the blocksize comes from:
+ *      1. UArray2b_set_blocksize
+ *      2. the UARRAY2B_BLOCKSIZE environment variable
+ *      3. the cache hierarchy: the largest power-of-two blocksize for which a
+ *         source and a destination block (2 * blocksize * blocksize * size 
+ *         bytes) both fit in the L2 cache, or in the L1 cache if the L2 size
+ *         is unknown
+ *      4. the 64KB rule of UArray2b_new_64K_block
+ * Inputs:
+ *              int size: integer storing the size (in bytes) of each element
+ *              const char **why: if not NULL, set to a short static string
+ *                        naming which of the sources above was used
+ * Return: the chosen blocksize, which is at least 1
+ * Expects:
+ *      size to be positive
+ * Notes:
+ *      Checked runtime error if size is nonpositive
+ *      A UARRAY2B_BLOCKSIZE that is not a positive integer is ignored
+ ************************/
+int UArray2b_auto_blocksize(int size, const char **why)
+{
+        static const char *cache_names[] = { NULL, "L1 cache", "L2 cache" };
+        const char *source = "64KB default";
+        int blocksize = 0;
+        assert(size > 0);
+
+        const char *env = getenv("UARRAY2B_BLOCKSIZE");
+        if (blocksize_override > 0) {
+                blocksize = blocksize_override;
+                source = "override";
+        } else if (env != NULL && atoi(env) >= 1) {
+                blocksize = atoi(env);
+                source = "UARRAY2B_BLOCKSIZE";
+        } else {
+                for (int level = TARGET_CACHE_LEVEL; level >= 1; level--) {
+                        long cache = Cacheinfo_size(level);
+                        if (cache > 0) {
+                                blocksize = floor_pow2(sqrt(cache / 
+                                                        (2.0 * size)));
+                                source = cache_names[level];
+                                break;
+                        }
+                }
+                if (blocksize == 0 && size <= SIXTY_FOUR_KB) {
+                        blocksize = floor_pow2(sqrt(SIXTY_FOUR_KB / size));
+                }
+        }
+
+        if (blocksize < 1) {
+                blocksize = 1;
+        }
+        if (why != NULL) {
+                *why = source;
+        }
+        return blocksize;
+}
+
+/**********UArray2b_set_blocksize********
+ *
+ * Overrides the blocksize chosen by UArray2b_auto_blocksize (and thus used
+ * by UArray2b_new_auto_block)
+ * Inputs:
+ *              int blocksize: the blocksize to use, or 0 to remove the 
+ *                             override
+ * Return: N/A
+ * Expects:
+ *      blocksize to be nonnegative
+ * Notes:
+ *      Checked runtime error if blocksize is negative
+ ************************/
+void UArray2b_set_blocksize(int blocksize)
+{
+        assert(blocksize >= 0);
+        blocksize_override = blocksize;
+}
+
+/**********UArray2b_auto_microsize********
+ *
+ * Chooses the micro-tile size for a two-level blocked array holding cells of
+ * size bytes in blocks of the given blocksize: the largest power of two for
+ * which a source and a destination micro-tile both fit in the L1 cache.
+ * Inputs:
+ *              int size: integer storing the size (in bytes) of each element
+ *              int blocksize: the blocksize of the array
+ *              const char **why: if not NULL, set to a short static string
+ *                        saying where the microsize came from
+ * Return: the chosen microsize, which divides blocksize
+ * Expects:
+ *      size and blocksize to be positive
+ * Notes:
+ *      Checked runtime error if size or blocksize is nonpositive
+ *      If the blocksize is not a power of two or the L1 size is unknown, the
+ *      microsize is the blocksize (a single level of blocking)
+ ************************/
+int UArray2b_auto_microsize(int size, int blocksize, const char **why)
+{
+        assert(size > 0);
+        assert(blocksize >= 1);
+        long cache = Cacheinfo_size(1);
+        int microsize = blocksize;
+        const char *source = "single level";
+
+        if (cache > 0 && exact_log2(blocksize) >= 0) {
+                microsize = floor_pow2(sqrt(cache / (2.0 * size)));
+                if (microsize > blocksize) {
+                        microsize = blocksize;
+                }
+                source = "L1 cache";
+        }
+        if (why != NULL) {
+                *why = source;
+        }
+        return microsize;
+}
+
+/**********UArray2b_set_two_level********
+ *
+ * Selects whether UArray2b_new_auto_block tiles at two levels, with 
+ * micro-tiles chosen by UArray2b_auto_microsize inside its blocks
+ * Inputs:
+ *              int enabled: nonzero for two levels, zero for one
+ * Return: N/A
+ ************************/
+void UArray2b_set_two_level(int enabled)
+{
+        two_level = enabled != 0;
+}
+
+/**********UArray2b_set_order********
+ *
+ * Selects the order of the cells inside the blocks made by 
+ * UArray2b_new_auto_block
+ * Inputs:
+ *              UArray2b_order order: UARRAY2B_ROW_MAJOR or UARRAY2B_COL_MAJOR
+ * Return: N/A
+ * Expects:
+ *      order to be one of the two UArray2b_order values
+ * Notes:
+ *      Checked runtime error if order is not a UArray2b_order value
+ ************************/
+void UArray2b_set_order(UArray2b_order order)
+{
+        assert(order == UARRAY2B_COL_MAJOR || order == UARRAY2B_ROW_MAJOR);
+        default_order = order;
+}
+
+/**********UArray2b_new_auto_block********
+ *
+ * Allocates, initializes and returns a new blocked UArray2 with width x height 
+ * cells, each of which are of size bytes, with the blocksize chosen by 
+ * UArray2b_auto_blocksize for this machine
+ * Inputs:
+ *              int width: integer storing the number of columns contained in 
+ *                         the UArray2b
+ *              int height: integer storing the number of rows contained in the
+ *                          UArray2b
+ *              int size: integer storing the size (in bytes) of each element
+ *                        in the new UArray2b
+ * Return: A new UArray2b with width x height number of elements, each of which
+ *         are of size bytes
+ * Expects:
+ *      * width and height to be nonnegative
+ *      * size to be positive
+ * Notes:
+ *      The blocksize is capped near the larger dimension of the array (at the
+ *      smallest power of two covering it, when the blocksize is a power of 
+ *      two), so small arrays are not padded out to a cache-sized block
+ *      When UArray2b_set_two_level is in effect, the blocks are cut into 
+ *      micro-tiles chosen by UArray2b_auto_microsize
+ *      The order inside blocks is the one set by UArray2b_set_order, 
+ *      column-major by default
+ *      This function utilizes the UArray2b_new_tiled function, and thus it 
+ *      initializes the checked runtime errors of that function
+ *      The client must free heap allocated memory using UArray2b_free
+ ************************/
+T UArray2b_new_auto_block(int width, int height, int size)
+{
+        int blocksize = UArray2b_auto_blocksize(size, NULL);
+        int longer = width > height ? width : height;
+        if (blocksize > longer && longer > 0) {
+                if (exact_log2(blocksize) >= 0) {
+                        while (blocksize / 2 >= longer) {
+                                blocksize /= 2;
+                        }
+                } else {
+                        blocksize = longer;
+                }
+        }
+        int microsize = blocksize;
+        if (two_level) {
+                microsize = UArray2b_auto_microsize(size, blocksize, NULL);
+        }
+        return UArray2b_new_tiled(width, height, size, blocksize, microsize,
+                                                                default_order);
+}
+
+/**********UArray2b_view********
+ *
+ * Returns a new UArray2b that is a window onto the cells of another, without
+ * copying them
+ * Inputs:
+ *              T array2b: the UArray2b (or view) to look into
+ *              int col, int row: the cell of array2b that is the top left 
+ *                      cell of the view
+ *              int width, int height: the number of columns and rows of the
+ *                      view
+ * Return: A UArray2b whose cell (i, j) is cell (col + i, row + j) of array2b
+ * Expects:
+ *      * array2b to be nonnull
+ *      * the window to lie inside array2b: col, row, width and height are 
+ *        nonnegative, col + width <= its width and row + height <= its 
+ *        height
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * Every UArray2b function accepts a view. Maps visit only the cells 
+ *        in the window, still block by block in storage order, and report 
+ *        indices relative to the view.
+ *      * A view of a view looks into the same slab as the original
+ *      * The client must free the view using UArray2b_free, which leaves 
+ *        the cells alone, and must not use it once array2b is freed
+ ************************/
+T UArray2b_view(T array2b, int col, int row, int width, int height)
+{
+        assert(array2b != NULL);
+        assert(col >= 0 && width >= 0 && col + width <= array2b->width);
+        assert(row >= 0 && height >= 0 && row + height <= array2b->height);
+        T view = malloc(sizeof(*view));
+        assert(view != NULL);
+        *view = *array2b;
+        view->parent = array2b->parent != NULL ? array2b->parent : array2b;
+        view->col0 = array2b->col0 + col;
+        view->row0 = array2b->row0 + row;
+        view->width = width;
+        view->height = height;
+        return view;
+}
+
 /**********UArray2b_free********
  *
  * Deallocates and clears the *UArray2b
@@ -169,18 +532,13 @@ T UArray2b_new_64K_block(int width, int height, int size)
  ************************/
 void UArray2b_free(T *array2b) 
 {
-        for (int b_col = 0; 
-                        b_col < UArray2_width((*array2b)->uarray2); b_col++) {
-                for (int b_row = 0; 
-                        b_row < UArray2_height((*array2b)->uarray2); b_row++) 
-                {
-                        UArray_T *ua = UArray2_at((*array2b)->uarray2, 
-                                                                b_col, b_row);
-                        UArray_free(&(*ua));
-                }
+        assert(array2b != NULL && *array2b != NULL);
+        if ((*array2b)->parent == NULL) {
+                Pixmem_free((*array2b)->slab, (*array2b)->slab_bytes, 
+                                                        (*array2b)->mapped);
         }
-        UArray2_free(&((*array2b)->uarray2));
         free(*array2b);
+        *array2b = NULL;
 }
 
 /**********UArray2b_width********
@@ -256,6 +614,35 @@ int UArray2b_blocksize (T array2b)
         return array2b->blocksize;
 }
 
+/**********UArray2b_microsize********
+ *
+ * Returns the number of cells in a side of a micro-tile of the UArray2b, 
+ * which equals its blocksize when it has a single level of blocking
+ * Expects:
+ *      Pointer to UArray2b to be nonnull
+ * Notes:
+ *      Checked runtime error if the UArray2b is null
+ ************************/
+int UArray2b_microsize(T array2b)
+{
+        assert(array2b != NULL);
+        return array2b->microsize;
+}
+
+/**********UArray2b_order_of********
+ *
+ * Returns the order of the cells inside the blocks of the UArray2b
+ * Expects:
+ *      Pointer to UArray2b to be nonnull
+ * Notes:
+ *      Checked runtime error if the UArray2b is null
+ ************************/
+UArray2b_order UArray2b_order_of(T array2b)
+{
+        assert(array2b != NULL);
+        return array2b->order;
+}
+
 /**********UArray2b_at********
  *
  * Returns a pointer to the element within the UArray2b provided in the first
@@ -279,20 +666,153 @@ int UArray2b_blocksize (T array2b)
  *              * UArray2b is null 
  *              * row value >= height or row value < 0
  *              * col value >= width or col value < 0
+ *      * The cell is located by UArray2b_at_unchecked in uarray2b_impl.h
  ************************/
 void *UArray2b_at(T array2b, int col, int row)
 {
         assert(array2b != NULL);
         assert(row >= 0 && row < array2b->height);
         assert(col >= 0 && col < array2b->width);
-        int block_col = col / array2b->blocksize;
-        int block_row = row / array2b->blocksize;
+        return UArray2b_at_unchecked(array2b, col, row);
+}
+
+/**********block_range********
+ *
+ * Finds the blocks that meet the UArray2b (its window, for a view): the 
+ * first block column and row, and the number of block columns and rows. 
+ * Both counts are 0 for an empty UArray2b.
+ ************************/
+static void block_range(T array2b, int *b_col, int *b_row, int *cols, 
+                        int *rows)
+{
+        int blocksize = array2b->blocksize;
+        *b_col = array2b->col0 / blocksize;
+        *b_row = array2b->row0 / blocksize;
+        *cols = 0;
+        *rows = 0;
+        if (array2b->width > 0 && array2b->height > 0) {
+                *cols = (array2b->col0 + array2b->width - 1) / blocksize
+                                                                - *b_col + 1;
+                *rows = (array2b->row0 + array2b->height - 1) / blocksize 
+                                                                - *b_row + 1;
+        }
+}
+
+/**********map_block_tiles********
+ *
+ * Calls visit once for each micro-tile of the block at (b_col, b_row), in
+ * the order the micro-tiles are stored, with the indices of its top left 
+ * cell, the number of its columns and rows that lie inside the UArray2b and
+ * a pointer to its top left cell. Micro-tiles entirely outside the UArray2b
+ * are skipped, and the others are clipped here, once per micro-tile. For a
+ * view each micro-tile is clipped to the window, so its top left cell may 
+ * lie inside it.
+ ************************/
+static void map_block_tiles(T array2b, int b_col, int b_row, 
+                            void visit(int col, int row, int width, 
+                                       int height, char *base, void *cl), 
+                            void *cl)
+{
+        int blocksize = array2b->blocksize;
+        int microsize = array2b->microsize;
+        int col_major = array2b->order == UARRAY2B_COL_MAJOR;
+        int size = array2b->size;
 
-        UArray_T *ua = UArray2_at(array2b->uarray2, block_col, block_row);
+        /* the window, in the coordinates of the slab's layout */
+        int left = array2b->col0;
+        int top = array2b->row0;
+        int right = left + array2b->width;
+        int bottom = top + array2b->height;
 
-        int ua_index = array2b->blocksize * (col % array2b->blocksize) 
-                                                + (row % array2b->blocksize);
-        return UArray_at(*ua, ua_index);
+        char *micro = block_at(array2b, b_col, b_row);
+        for (int major = 0; major < array2b->micro_side; major++) {
+                for (int minor = 0; minor < array2b->micro_side; minor++) {
+                        int col = b_col * blocksize + 
+                                        microsize * (col_major ? major : minor);
+                        int row = b_row * blocksize + 
+                                        microsize * (col_major ? minor : major);
+                        char *base = micro;
+                        micro += array2b->micro_bytes;
+
+                        /* clip to the window */
+                        int c0 = col > left ? col : left;
+                        int r0 = row > top ? row : top;
+                        int c1 = col + microsize < right ? 
+                                                col + microsize : right;
+                        int r1 = row + microsize < bottom ? 
+                                                row + microsize : bottom;
+                        if (c0 >= c1 || r0 >= r1) {
+                                continue;
+                        }
+                        int skip = col_major ? 
+                                (c0 - col) * microsize + (r0 - row) :
+                                (r0 - row) * microsize + (c0 - col);
+                        visit(c0 - left, r0 - top, c1 - c0, r1 - r0, 
+                                                base + (size_t)skip * size, cl);
+                }
+        }
+}
+
+/**********map_tiles********
+ *
+ * Calls visit (see map_block_tiles) for each micro-tile of the UArray2b, 
+ * block by block in the order the blocks are stored. For a view only the 
+ * blocks that meet its window are visited.
+ ************************/
+static void map_tiles(T array2b, void visit(int col, int row, int width, 
+                      int height, char *base, void *cl), void *cl)
+{
+        int b_col, b_row, cols, rows;
+        block_range(array2b, &b_col, &b_row, &cols, &rows);
+        for (int r = b_row; r < b_row + rows; r++) {
+                for (int c = b_col; c < b_col + cols; c++) {
+                        map_block_tiles(array2b, c, r, visit, cl);
+                }
+        }
+}
+
+/*
+ * closure used by walk_cells to carry UArray2b_map's apply function
+ */
+struct cell_walk {
+        T array2b;
+        void (*apply)(int col, int row, T array2b, void *elem, void *cl);
+        void *cl;
+};
+
+/**********walk_cells********
+ *
+ * Calls the apply function of a cell_walk for every cell of one micro-tile,
+ * stepping a pointer through the micro-tile in storage order, with a loop 
+ * nest specialized for each order
+ ************************/
+static void walk_cells(int col, int row, int width, int height, char *base,
+                       void *vcl)
+{
+        struct cell_walk *walk = vcl;
+        T array2b = walk->array2b;
+        int size = array2b->size;
+        size_t line_bytes = (size_t)array2b->microsize * size;
+
+        if (array2b->order == UARRAY2B_COL_MAJOR) {
+                for (int c = col; c < col + width; c++) {
+                        char *elem = base;
+                        for (int r = row; r < row + height; r++) {
+                                walk->apply(c, r, array2b, elem, walk->cl);
+                                elem += size;
+                        }
+                        base += line_bytes;
+                }
+        } else {
+                for (int r = row; r < row + height; r++) {
+                        char *elem = base;
+                        for (int c = col; c < col + width; c++) {
+                                walk->apply(c, r, array2b, elem, walk->cl);
+                                elem += size;
+                        }
+                        base += line_bytes;
+                }
+        }
 }
 
 /**********UArray2b_map********
@@ -324,34 +844,459 @@ void *UArray2b_at(T array2b, int col, int row)
  *      * The col value is positive and is less than the width of the UArray2b
  * Notes:
  *      Updates the UArray2b entered in as the first parameter 
+ *      With two levels of blocking, every cell of a micro-tile is visited 
+ *      before the next micro-tile, and every micro-tile of a block before the
+ *      next block
+ *      The cells of each micro-tile are reached by stepping a pointer through
+ *      it, and tiles on the right and bottom edges are clipped once per tile,
+ *      so no divisions or bounds tests happen per cell
  ************************/
 void UArray2b_map(T array2b, void apply(int col, int row, T array2b, 
                                         void *elem, void *cl), void *cl) 
 {       
-        int blocksize = array2b->blocksize;
-        int width = array2b->width;
-        int height = array2b->height;
-        for (int b_col = 0; b_col < UArray2_width(array2b->uarray2); b_col++) {
-                for (int b_row = 0; b_row < UArray2_height(array2b->uarray2); 
-                                                                b_row++) 
-                {
-                        UArray_T *ua = UArray2_at(array2b->uarray2, b_col, 
-                                                                        b_row);
-                        for (int c = b_col * blocksize; 
-                                c < b_col * blocksize + blocksize; c++) {
-                                for (int r = b_row * blocksize; 
-                                        r < b_row * blocksize + blocksize; r++) 
-                                {
-                                        if (c < width && r < height) 
-                                        {
-                                                int ua_index = blocksize * 
-                                                        (c % blocksize) + 
-                                                        (r % blocksize);
-                                                apply(c, r, array2b, UArray_at
-                                                        (*ua, ua_index), cl);
-                                        }
-                                }        
+        assert(array2b != NULL);
+        struct cell_walk walk = { array2b, apply, cl };
+        map_tiles(array2b, walk_cells, &walk);
+}
+
+/*
+ * closure used by walk_runs to carry UArray2b_map_runs's apply function
+ */
+struct run_walk {
+        T array2b;
+        void (*apply)(int col, int row, int down, T array2b, void *base, 
+                      int count, void *cl);
+        void *cl;
+};
+
+/**********walk_runs********
+ *
+ * Calls the apply function of a run_walk once for each contiguous line of 
+ * one micro-tile: each column for column-major blocks, each row otherwise
+ ************************/
+static void walk_runs(int col, int row, int width, int height, char *base,
+                      void *vcl)
+{
+        struct run_walk *walk = vcl;
+        T array2b = walk->array2b;
+        size_t line_bytes = (size_t)array2b->microsize * array2b->size;
+
+        if (array2b->order == UARRAY2B_COL_MAJOR) {
+                for (int c = col; c < col + width; c++) {
+                        walk->apply(c, row, 1, array2b, base, height, 
+                                                                walk->cl);
+                        base += line_bytes;
+                }
+        } else {
+                for (int r = row; r < row + height; r++) {
+                        walk->apply(col, r, 0, array2b, base, width, 
+                                                                walk->cl);
+                        base += line_bytes;
+                }
+        }
+}
+
+/**********UArray2b_map_runs********
+ *
+ * Calls an apply function once for each contiguous run of cells in 
+ * UArray2b, visiting the cells in the same order as UArray2b_map
+ * Inputs:
+ *              T array2b: A pointer to the UArray2b whose runs will be 
+ *                         visited
+ *              void apply: The function that will be applied to each run
+ *                  int col, int row: the indices of the first cell of the run
+ *                  int down: 1 if the run goes down a column (the cells 
+ *                            (col, row + k)), 0 if it goes along a row (the 
+ *                            cells (col + k, row))
+ *                  T array2b: A pointer to the same UArray2b passed into the
+ *                             outside function
+ *                  void *base: A pointer to the first cell of the run; the 
+ *                              kth cell is base + k * size
+ *                  int count: the number of cells in the run
+ *                  void *cl: A closure passed in by the client to be used in 
+ *                            the apply function  
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function               
+ * Return: N/A
+ * Expects: 
+ *      * UArray2b to be nonnull
+ * Notes:
+ *      * Checked runtime error if the UArray2b is null
+ *      * A run is one line of a micro-tile, clipped to the UArray2b (or to 
+ *        the window of a view), so it is at most microsize cells long
+ ************************/
+void UArray2b_map_runs(T array2b, void apply(int col, int row, int down, 
+                       T array2b, void *base, int count, void *cl), void *cl)
+{
+        assert(array2b != NULL);
+        struct run_walk walk = { array2b, apply, cl };
+        map_tiles(array2b, walk_runs, &walk);
+}
+
+/*
+ * closure used by UArray2b_par_map to share the blocks of a UArray2b among
+ * threads: block task index is the block at (b_col + index % cols, 
+ * b_row + index / cols)
+ */
+struct block_tasks {
+        struct cell_walk walk;
+        int b_col, b_row;
+        int cols;
+};
+
+/**********walk_block********
+ *
+ * Parmap task that visits every cell of one block, micro-tile by 
+ * micro-tile, in storage order
+ ************************/
+static void walk_block(int index, void *vcl)
+{
+        struct block_tasks *tasks = vcl;
+        map_block_tiles(tasks->walk.array2b, tasks->b_col + index % tasks->cols,
+                        tasks->b_row + index / tasks->cols, walk_cells, 
+                        &tasks->walk);
+}
+
+/**********UArray2b_par_map********
+ *
+ * Calls an apply function for each element in UArray2b using several 
+ * threads. Each block is a task for Parmap_run, so a thread visits every 
+ * cell of a block (in the same order as UArray2b_map) before taking 
+ * another, and idle threads steal blocks from busy ones.
+ * Inputs:
+ *              T array2b: A pointer to the UArray2b that the apply function 
+ *                         will be called on
+ *              void apply: The function that will be applied to each element
+ *                          (see UArray2b_map)
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function
+ * Return: N/A
+ * Expects: 
+ *      * UArray2b to be nonnull
+ *      * apply to be safe to call from several threads at once for 
+ *        different elements
+ * Notes:
+ *      * Checked runtime error if UArray2b is null
+ *      * Blocks are visited in no particular order overall
+ ************************/
+void UArray2b_par_map(T array2b, void apply(int col, int row, T array2b, 
+                                            void *elem, void *cl), void *cl)
+{
+        assert(array2b != NULL);
+        struct block_tasks tasks = { { array2b, apply, cl }, 0, 0, 0 };
+        int rows;
+        block_range(array2b, &tasks.b_col, &tasks.b_row, &tasks.cols, &rows);
+        Parmap_run(tasks.cols * rows, walk_block, &tasks);
+}
+
+/*
+ * closure used by walk_tile to carry UArray2b_map_blocks' apply function 
+ * and the strides of a micro-tile
+ */
+struct tile_walk {
+        int col_stride;
+        int row_stride;
+        void (*apply)(int col, int row, int width, int height, void *base, 
+                      int col_stride, int row_stride, void *cl);
+        void *cl;
+};
+
+/**********walk_tile********
+ *
+ * Passes one micro-tile on to the apply function of a tile_walk
+ ************************/
+static void walk_tile(int col, int row, int width, int height, char *base,
+                      void *vcl)
+{
+        struct tile_walk *walk = vcl;
+        walk->apply(col, row, width, height, base, walk->col_stride, 
+                                                walk->row_stride, walk->cl);
+}
+
+/**********UArray2b_map_blocks********
+ *
+ * Calls an apply function once for each block in UArray2b, in the order the
+ * blocks are stored. Each call describes the part of the block that lies 
+ * inside the UArray2b, so clients can run a tight loop (or a whole-block 
+ * kernel) over it without testing bounds per cell. With two levels of 
+ * blocking each micro-tile is passed as a block of its own.
+ * Inputs:
+ *              T array2b: A pointer to the UArray2b whose blocks will be 
+ *                         visited
+ *              void apply: The function that will be applied to each block
+ *                  int col, int row: the indices of the top left cell of the
+ *                                    block
+ *                  int width, int height: the number of columns and rows of
+ *                                    the block inside the UArray2b, which is
+ *                                    less than the blocksize only for blocks
+ *                                    on the right and bottom edges
+ *                  void *base: A pointer to the cell at (col, row)
+ *                  int col_stride: bytes between the cells at (c, r) and 
+ *                                  (c + 1, r) of the block
+ *                  int row_stride: bytes between the cells at (c, r) and 
+ *                                  (c, r + 1) of the block
+ *                  void *cl: the closure passed to UArray2b_map_blocks
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function
+ * Return: N/A
+ * Expects:
+ *      UArray2b to be nonnull
+ * Notes:
+ *      Checked runtime error if the UArray2b is null
+ ************************/
+void UArray2b_map_blocks(T array2b, void apply(int col, int row, int width, 
+                                int height, void *base, int col_stride, 
+                                int row_stride, void *cl), void *cl)
+{
+        assert(array2b != NULL);
+        int line_bytes = array2b->microsize * array2b->size;
+        struct tile_walk walk = { line_bytes, array2b->size, apply, cl };
+        if (array2b->order == UARRAY2B_ROW_MAJOR) {
+                walk.col_stride = array2b->size;
+                walk.row_stride = line_bytes;
+        }
+        map_tiles(array2b, walk_tile, &walk);
+}
+
+/*
+ * closure used by gather_tile: the UArray2b being read and the affine form
+ * of the op that takes a cell of the UArray2b being written back to it
+ */
+struct gather {
+        T src;
+        T dst;
+        Dihedral_steps from;
+};
+
+/**********gather_tile********
+ *
+ * Fills one micro-tile of the destination of UArray2b_transform, in storage
+ * order, with the source cells that land on it. Each line of the 
+ * destination reads a straight line of the source, so a source pointer is 
+ * stepped along it at a fixed stride while it stays inside one source 
+ * micro-tile, and located afresh only where it crosses into the next.
+ ************************/
+static void gather_tile(int col, int row, int width, int height, char *base,
+                        void *vcl)
+{
+        struct gather *g = vcl;
+        T src = g->src;
+        const Dihedral_steps *from = &g->from;
+        int size = g->dst->size;
+        size_t line_bytes = (size_t)g->dst->microsize * size;
+        int col_major = g->dst->order == UARRAY2B_COL_MAJOR;
+
+        /* a line is a contiguous column (or row) of the micro-tile */
+        int lines = col_major ? width : height;
+        int cells = col_major ? height : width;
+        int dcol = col_major ? from->dcol_row : from->dcol_col;
+        int drow = col_major ? from->drow_row : from->drow_col;
+
+        /* the line runs along one axis of the source, one cell a step */
+        int m = src->microsize;
+        int src_col_major = src->order == UARRAY2B_COL_MAJOR;
+        int col_stride = src_col_major ? m * size : size;
+        int row_stride = src_col_major ? size : m * size;
+        int stride = dcol * col_stride + drow * row_stride;
+        int forward = dcol + drow > 0;
+        for (int l = 0; l < lines; l++) {
+                int c = col + (col_major ? l : 0);
+                int r = row + (col_major ? 0 : l);
+                int src_col = from->col0 + c * from->dcol_col + 
+                                                r * from->dcol_row;
+                int src_row = from->row0 + c * from->drow_col + 
+                                                r * from->drow_row;
+                char *out = base + l * line_bytes;
+                for (int k = 0; k < cells; ) {
+                        int along = (dcol != 0 ? src_col + src->col0 
+                                               : src_row + src->row0) % m;
+                        int run = forward ? m - along : along + 1;
+                        if (run > cells - k) {
+                                run = cells - k;
                         }
+                        const char *in = UArray2b_at_unchecked(src, src_col,
+                                                               src_row);
+                        for (int n = 0; n < run; n++) {
+                                memcpy(out, in, size);
+                                out += size;
+                                in += stride;
+                        }
+                        k += run;
+                        src_col += run * dcol;
+                        src_row += run * drow;
                 }
         }
 }
+
+/**********UArray2b_transform********
+ *
+ * Copies every cell of one UArray2b to its place in another under one of 
+ * the eight symmetries of a rectangle
+ * Inputs:
+ *              T src: the UArray2b to transform
+ *              T dst: the UArray2b that receives the transformed cells
+ *              Dihedral_op op: where each cell goes (see dihedral.h)
+ * Return: N/A
+ * Expects:
+ *      * src and dst to be nonnull, distinct and to have the same cell size
+ *      * dst to be src->height x src->width if op swaps the dimensions, and 
+ *        src->width x src->height otherwise
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The destination is walked micro-tile by micro-tile in storage order
+ *        and each cell is gathered from the source. A destination block 
+ *        draws on at most four source blocks, and the automatic blocksize 
+ *        keeps a source and a destination block in the L2 cache together, 
+ *        so reads stay local in any order; writing in storage order is then
+ *        the cheaper side to keep sequential. The arrays may have different
+ *        blocksizes or orders.
+ *      * Either array may be a view
+ ************************/
+void UArray2b_transform(T src, T dst, Dihedral_op op)
+{
+        assert(src != NULL && dst != NULL && src != dst);
+        assert(src->size == dst->size);
+        assert(Dihedral_swaps(op) 
+                ? dst->width == src->height && dst->height == src->width
+                : dst->width == src->width && dst->height == src->height);
+        struct gather g = { src, dst, 
+                            Dihedral_steps_of(Dihedral_inverse(op), 
+                                              dst->width, dst->height) };
+        map_tiles(dst, gather_tile, &g);
+}
+
+/*
+ * closure used by swap_tile: the UArray2b being transformed in place and
+ * the affine form of the op
+ */
+struct swap {
+        T array2b;
+        Dihedral_steps to;
+};
+
+/**********swap_cell********
+ *
+ * Exchanges the size bytes at a with those at b. Called with a constant 
+ * size, the compiler turns the swap into a few moves.
+ ************************/
+static inline void swap_cell(char *a, char *b, int size)
+{
+        char tmp[16];
+        for (int done = 0; done < size; done += (int)sizeof(tmp)) {
+                int n = size - done < (int)sizeof(tmp) ? size - done 
+                                                       : (int)sizeof(tmp);
+                memcpy(tmp, a + done, n);
+                memcpy(a + done, b + done, n);
+                memcpy(b + done, tmp, n);
+        }
+}
+
+/**********swap_lines********
+ *
+ * Walks the cells of one micro-tile in storage order, as gather_tile does,
+ * and swaps each cell with its partner under the op when the partner comes
+ * later in row-major order, so each pair is swapped once
+ ************************/
+static inline void swap_lines(struct swap *sw, int col, int row, int width, 
+                              int height, char *base, int size)
+{
+        T array2b = sw->array2b;
+        const Dihedral_steps *to = &sw->to;
+        size_t line_bytes = (size_t)array2b->microsize * size;
+        int col_major = array2b->order == UARRAY2B_COL_MAJOR;
+
+        int lines = col_major ? width : height;
+        int cells = col_major ? height : width;
+        int dcol = col_major ? to->dcol_row : to->dcol_col;
+        int drow = col_major ? to->drow_row : to->drow_col;
+        for (int l = 0; l < lines; l++) {
+                int c = col + (col_major ? l : 0);
+                int r = row + (col_major ? 0 : l);
+                int to_col = to->col0 + c * to->dcol_col + r * to->dcol_row;
+                int to_row = to->row0 + c * to->drow_col + r * to->drow_row;
+                char *elem = base + l * line_bytes;
+                for (int k = 0; k < cells; k++) {
+                        if (to_row > r || (to_row == r && to_col > c)) {
+                                swap_cell(elem, UArray2b_at_unchecked(array2b,
+                                                to_col, to_row), size);
+                        }
+                        elem += size;
+                        to_col += dcol;
+                        to_row += drow;
+                        c += !col_major;
+                        r += col_major;
+                }
+        }
+}
+
+/**********swap_tile********
+ *
+ * Swaps the cells of one micro-tile of the UArray2b being transformed in 
+ * place with their partners, with the cell swaps specialized for the 
+ * common cell sizes. Under a flip or the half turn no cell to the right of
+ * or below a cell whose partner does not come after it has a later partner
+ * either, so a micro-tile whose top left cell is such a cell has no swaps
+ * of its own left to make and is skipped untouched.
+ ************************/
+static void swap_tile(int col, int row, int width, int height, char *base,
+                      void *vcl)
+{
+        struct swap *sw = vcl;
+        const Dihedral_steps *to = &sw->to;
+        int to_col = to->col0 + col * to->dcol_col + row * to->dcol_row;
+        int to_row = to->row0 + col * to->drow_col + row * to->drow_row;
+        if (to_row < row || (to_row == row && to_col <= col)) {
+                return;
+        }
+        switch (sw->array2b->size) {
+        case 4:
+                swap_lines(sw, col, row, width, height, base, 4);
+                break;
+        case 8:
+                swap_lines(sw, col, row, width, height, base, 8);
+                break;
+        case 12:
+                swap_lines(sw, col, row, width, height, base, 12);
+                break;
+        case 16:
+                swap_lines(sw, col, row, width, height, base, 16);
+                break;
+        default:
+                swap_lines(sw, col, row, width, height, base, 
+                           sw->array2b->size);
+                break;
+        }
+}
+
+/**********UArray2b_transform_in_place********
+ *
+ * Moves every cell of a UArray2b to its place under one of the symmetries 
+ * of a rectangle that keep its dimensions, without a second array
+ * Inputs:
+ *              T array2b: the UArray2b to transform
+ *              Dihedral_op op: where each cell goes (see dihedral.h)
+ * Return: N/A
+ * Expects:
+ *      * array2b to be nonnull
+ *      * op not to swap the dimensions (Dihedral_swaps(op) == 0)
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The flips and the half turn are their own inverses, so each cell 
+ *        trades places with the cell it is sent to. The micro-tiles are 
+ *        walked in storage order and each pair is swapped when its earlier
+ *        cell (in row-major order) is reached; the micro-tiles of the later
+ *        half are skipped. The partner micro-tile mirrors the one being 
+ *        walked, so both stay in the cache while their cells are swapped.
+ *      * array2b may be a view
+ ************************/
+void UArray2b_transform_in_place(T array2b, Dihedral_op op)
+{
+        assert(array2b != NULL);
+        assert(!Dihedral_swaps(op));
+        if (op == DIHEDRAL_IDENTITY) {
+                return;
+        }
+        struct swap sw = { array2b, Dihedral_steps_of(op, array2b->width, 
+                                                      array2b->height) };
+        map_tiles(array2b, swap_tile, &sw);
+}
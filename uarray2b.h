@@ -0,0 +1,144 @@
+/*
+ *     uarray2b.h
+ *     by Kabir Pamnani and Alex Shriver, 02/22/2023
+ *     HW3: Locality
+ *
+ *     Summary: Interface for 2D Unboxed Blocked Arrays
+ */
+
+#ifndef UARRAY2B_INCLUDED
+#define UARRAY2B_INCLUDED
+#include "dihedral.h"
+
+#define T UArray2b_T
+typedef struct T *T;
+
+/* order of the cells (and micro-tiles) inside a block */
+typedef enum { UARRAY2B_COL_MAJOR, UARRAY2B_ROW_MAJOR } UArray2b_order;
+
+/* 
+ * new blocked 2d array: blocksize = square root of # of cells in block.
+ * It is a checked runtime error for blocksize to be less than 1.
+ */
+extern T UArray2b_new(int width, int height, int size, int blocksize);
+
+/* new blocked 2d array: blocksize as large as possible provided block 
+ * occupies at most 64KB (if possible)
+ */
+extern T UArray2b_new_64K_block(int width, int height, int size);
+
+/* 
+ * new blocked 2d array with two levels of blocking: each blocksize x 
+ * blocksize block is cut into microsize x microsize micro-tiles. It is a 
+ * checked runtime error for microsize not to divide blocksize.
+ */
+extern T UArray2b_new_two_level(int width, int height, int size, 
+                                int blocksize, int microsize);
+
+/* 
+ * new blocked 2d array with two levels of blocking whose cells are stored in
+ * the given order inside micro-tiles (and micro-tiles inside blocks)
+ */
+extern T UArray2b_new_tiled(int width, int height, int size, int blocksize,
+                            int microsize, UArray2b_order order);
+
+/* new blocked 2d array: blocksize chosen by UArray2b_auto_blocksize */
+extern T UArray2b_new_auto_block(int width, int height, int size);
+
+/* 
+ * Returns the blocksize UArray2b_new_auto_block uses for cells of size 
+ * bytes: the override if one is set, otherwise the largest blocksize for 
+ * which a source and a destination block both fit in the L2 cache of this 
+ * machine. If why is not NULL, *why is set to a short description of where
+ * the blocksize came from.
+ */
+extern int UArray2b_auto_blocksize(int size, const char **why);
+
+/* 
+ * Sets the blocksize used by UArray2b_new_auto_block, overriding both the
+ * UARRAY2B_BLOCKSIZE environment variable and the cache sizes. A blocksize
+ * of 0 removes the override.
+ */
+extern void UArray2b_set_blocksize(int blocksize);
+
+/* 
+ * Returns the microsize UArray2b_new_auto_block uses inside blocks of the
+ * given blocksize when tiling at two levels: the largest power of two for 
+ * which a source and a destination micro-tile both fit in the L1 cache.
+ */
+extern int UArray2b_auto_microsize(int size, int blocksize, const char **why);
+
+/* selects whether UArray2b_new_auto_block tiles at one level or two */
+extern void UArray2b_set_two_level(int enabled);
+
+/* selects the order inside blocks made by UArray2b_new_auto_block */
+extern void UArray2b_set_order(UArray2b_order order);
+
+/* 
+ * new view of the width x height window of array2b whose top left cell is
+ * (col, row). The view shares array2b's cells, so (i, j) of the view is 
+ * (col + i, row + j) of array2b. It is a checked runtime error for the 
+ * window not to lie inside array2b. A view is freed with UArray2b_free, 
+ * which leaves the cells alone, and must not outlive array2b.
+ */
+extern T UArray2b_view(T array2b, int col, int row, int width, int height);
+
+extern void UArray2b_free(T *array2b);
+extern int UArray2b_width(T array2b);
+extern int UArray2b_height(T array2b);
+extern int UArray2b_size(T array2b);
+extern int UArray2b_blocksize(T array2b);
+extern int UArray2b_microsize(T array2b);
+extern UArray2b_order UArray2b_order_of(T array2b);
+extern void *UArray2b_at(T array2b, int col, int row);
+
+/* visits every cell in one block before moving to another block */
+extern void UArray2b_map(T array2b, void apply(int col, int row, T array2b, 
+                                        void *elem, void *cl), void *cl);
+
+/* 
+ * calls apply once per contiguous run of cells, visiting the blocks in the 
+ * same order as UArray2b_map: a run is a column of a micro-tile (down is 1)
+ * for column-major blocks and a row (down is 0) for row-major ones, clipped
+ * to the array. The run starts at (col, row) and its count cells follow 
+ * base contiguously.
+ */
+extern void UArray2b_map_runs(T array2b, void apply(int col, int row, 
+                              int down, T array2b, void *base, int count, 
+                              void *cl), void *cl);
+
+/* 
+ * parallel block-major map: apply is called once for each element, from up
+ * to Parmap_threads() threads at once, each visiting whole blocks. apply 
+ * must be safe to call concurrently for different elements.
+ */
+extern void UArray2b_par_map(T array2b, void apply(int col, int row, 
+                             T array2b, void *elem, void *cl), void *cl);
+
+/* 
+ * calls apply once per block, in storage order, with the block's top left 
+ * cell (col, row), the number of its columns and rows that lie inside the 
+ * array, a pointer to its top left cell and the distances in bytes between
+ * horizontally and vertically adjacent cells of the block
+ */
+extern void UArray2b_map_blocks(T array2b, void apply(int col, int row, 
+                                int width, int height, void *base, 
+                                int col_stride, int row_stride, void *cl), 
+                                void *cl);
+
+/* 
+ * copies each cell of src to its place in dst under op, which must be 
+ * distinct from src, have the same cell size and have src's dimensions 
+ * (swapped if Dihedral_swaps(op)), walking dst one micro-tile at a time
+ */
+extern void UArray2b_transform(T src, T dst, Dihedral_op op);
+
+/* 
+ * moves each cell of array2b to its place under op without a second array,
+ * by swapping cells with their partners a micro-tile at a time; op must not
+ * swap the dimensions (a flip, the half turn or the identity)
+ */
+extern void UArray2b_transform_in_place(T array2b, Dihedral_op op);
+
+#undef T
+#endif
@@ -0,0 +1,142 @@
+/*
+ *     uarray2b_impl.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Representation of 2D Unboxed Blocked Arrays, exposed so that
+ *              hot loops can inline an unchecked accessor instead of calling
+ *              UArray2b_at in another translation unit. Clients that only 
+ *              need the interface should include uarray2b.h instead.
+ */
+
+#ifndef UARRAY2B_IMPL_INCLUDED
+#define UARRAY2B_IMPL_INCLUDED
+
+#include <stddef.h>
+#include "uarray2b.h"
+
+/*
+ * This is the struct definition of the UArray2b_T instance
+ * Elements:
+ *      char *slab: A single cache-line-aligned allocation holding every block
+ *              of the UArray2b back to back. Blocks are stored in row-major
+ *              order (all the blocks of block row 0, then block row 1, ...).
+ *              Each block is cut into microsize x microsize micro-tiles 
+ *              stored back to back, and the cells of a micro-tile are stored
+ *              back to back, both in the order given by the order field, so
+ *              a cell is located by arithmetic alone. With a single level of
+ *              blocking the microsize equals the blocksize and each block is
+ *              one micro-tile.
+ *      int width: the number of columns in the UArray2b
+ *      int height: the number of rows in the UArray2b
+ *      int size: The size, in bytes, of each UArray2b element
+ *      int blocksize: The number of elements in a side of a block of the 
+ *              UArray2b, thus each block contains blocksize * blocksize
+ *              elements.
+ *      int microsize: The number of elements in a side of a micro-tile,
+ *              which divides the blocksize
+ *      int micro_side: the number of micro-tiles in a side of a block
+ *      int block_width: the number of blocks in a row of blocks
+ *      int block_height: the number of blocks in a column of blocks
+ *      size_t block_bytes: the number of bytes occupied by one block
+ *      size_t micro_bytes: the number of bytes occupied by one micro-tile
+ *      size_t slab_bytes: the number of bytes of storage at slab
+ *      int mapped: how the slab was obtained, for Pixmem_free
+ *      int log_blocksize, log_microsize: log2 of the blocksize and microsize
+ *              when both are powers of two, which lets UArray2b_at use shifts
+ *              and masks instead of divisions; -1 otherwise
+ *      UArray2b_order order: whether the micro-tiles of a block and the cells
+ *              of a micro-tile are stored in column-major order (a column of
+ *              cells is contiguous) or in row-major order (a row of cells is
+ *              contiguous)
+ *      struct UArray2b_T *parent: for a view made by UArray2b_view, the 
+ *              UArray2b that owns the slab; NULL for an array that owns it
+ *      int col0, row0: the cell of the slab's layout that is (0, 0) of this
+ *              UArray2b. They are 0 unless this is a view, whose width and 
+ *              height are then the extent of its window and whose block 
+ *              geometry is that of the array that owns the slab.
+ *              
+ */
+struct UArray2b_T {
+        char *slab;
+        int width;
+        int height;
+        int size;
+        int blocksize;
+        int microsize;
+        int micro_side;
+        int block_width;
+        int block_height;
+        size_t block_bytes;
+        size_t micro_bytes;
+        size_t slab_bytes;
+        int mapped;
+        int log_blocksize;
+        int log_microsize;
+        UArray2b_order order;
+        struct UArray2b_T *parent;
+        int col0;
+        int row0;
+};
+
+/**********UArray2b_at_unchecked********
+ *
+ * Returns a pointer to the element at (col, row), like UArray2b_at, but with
+ * no checks at all
+ * Expects:
+ *      * array2b to be nonnull
+ *      * 0 <= col < width and 0 <= row < height
+ * Notes:
+ *      * Unchecked runtime error if any of the above is false
+ *      * When the blocksize and microsize are powers of two the cell is 
+ *        located with shifts and masks rather than divisions
+ *      * Both orders share one computation: the coordinate that varies 
+ *        slowest inside a block (the column for column-major blocks, the row
+ *        for row-major ones) is simply used as the major index
+ ************************/
+static inline void *UArray2b_at_unchecked(UArray2b_T array2b, int col, 
+                                                                int row)
+{
+        col += array2b->col0;
+        row += array2b->row0;
+        int shift = array2b->log_blocksize;
+        if (shift >= 0) {
+                int micro_shift = array2b->log_microsize;
+                int mask = array2b->blocksize - 1;
+                int micro_mask = array2b->microsize - 1;
+                char *block = array2b->slab + ((size_t)(row >> shift) * 
+                        array2b->block_width + (col >> shift)) * 
+                        array2b->block_bytes;
+                int major = array2b->order == UARRAY2B_COL_MAJOR ? col : row;
+                int minor = array2b->order == UARRAY2B_COL_MAJOR ? row : col;
+                major &= mask;
+                minor &= mask;
+                size_t micro = ((major >> micro_shift) << 
+                                (shift - micro_shift)) | (minor >> micro_shift);
+                size_t index = (micro << (2 * micro_shift)) 
+                                | ((major & micro_mask) << micro_shift) 
+                                | (minor & micro_mask);
+                return block + index * array2b->size;
+        }
+
+        int blocksize = array2b->blocksize;
+        int microsize = array2b->microsize;
+        char *block = array2b->slab + ((size_t)(row / blocksize) * 
+                        array2b->block_width + col / blocksize) * 
+                        array2b->block_bytes;
+        int major = array2b->order == UARRAY2B_COL_MAJOR ? col : row;
+        int minor = array2b->order == UARRAY2B_COL_MAJOR ? row : col;
+        major %= blocksize;
+        minor %= blocksize;
+        if (microsize != blocksize) {
+                int micro = (major / microsize) * array2b->micro_side 
+                                                        + minor / microsize;
+                block += micro * array2b->micro_bytes;
+                major %= microsize;
+                minor %= microsize;
+        }
+        size_t index = (size_t)microsize * major + minor;
+        return block + index * array2b->size;
+}
+
+#endif
@@ -0,0 +1,358 @@
+/*
+ *     uarray2m.c
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Implementation of 2D Unboxed Arrays stored in Morton
+ *              (Z-order) layout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "uarray2m.h"
+#include "pixmem.h"
+
+#define T UArray2m_T
+
+/*********************************
+ *******      NOTE      **********
+ ********************************/
+/*
+* It is a checked run-time error to pass a NULL T
+* to any function in this interface
+*/
+
+/*
+ * This is the struct definition of the UArray2m_T instance
+ * Elements:
+ *      char *elems: A single cache-line-aligned allocation holding every cell
+ *      size_t nbytes: the number of bytes of storage at elems
+ *      int mapped: how the storage was obtained, for Pixmem_free
+ *      int width: the number of columns in the UArray2m
+ *      int height: the number of rows in the UArray2m
+ *      int size: The size, in bytes, of each UArray2m element
+ *      int log_side: log2 of the side of the square tiles the array is cut
+ *              into. The side is the smallest power of two that covers the
+ *              shorter dimension of the array.
+ *      int squares: the number of square tiles, which are laid side by side
+ *              along the longer dimension of the array
+ *      int wide: 1 if the squares are laid left to right (the array is at
+ *              least as wide as it is high), 0 if they are laid top to bottom
+ *
+ * Cells inside a square are stored along a Z-order curve by interleaving the
+ * bits of their column (even bits) and row (odd bits). The squares are
+ * stored one after another, so a non-square array wastes at most the padding
+ * of its shorter dimension up to a power of two plus a partial last square.
+ */
+struct T {
+        char *elems;
+        size_t nbytes;
+        int mapped;
+        int width;
+        int height;
+        int size;
+        int log_side;
+        int squares;
+        int wide;
+};
+
+/**********spread_bits********
+ *
+ * Returns n with a zero bit inserted above each of its bits, so bit i of n
+ * becomes bit 2i of the result
+ ************************/
+static inline uint64_t spread_bits(uint32_t n)
+{
+        uint64_t x = n;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+        x = (x | (x << 8))  & 0x00FF00FF00FF00FFULL;
+        x = (x | (x << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+        x = (x | (x << 2))  & 0x3333333333333333ULL;
+        x = (x | (x << 1))  & 0x5555555555555555ULL;
+        return x;
+}
+
+/**********morton_index********
+ *
+ * Returns the position of the cell at (col, row) in the storage of array2m
+ ************************/
+static inline uint64_t morton_index(T array2m, int col, int row)
+{
+        int k = array2m->log_side;
+        uint32_t mask = (1u << k) - 1;
+        uint64_t square;
+        if (array2m->wide) {
+                square = (uint32_t)col >> k;
+                col &= mask;
+        } else {
+                square = (uint32_t)row >> k;
+                row &= mask;
+        }
+        return (square << (2 * k)) | spread_bits(col) |
+                                                (spread_bits(row) << 1);
+}
+
+/**********UArray2m_new********
+ *
+ * Allocates, initializes and returns a new Morton-ordered UArray2 with
+ * width x height cells, each of which are of size bytes
+ * Inputs:
+ *              int width: integer storing the number of columns contained in
+ *                         the UArray2m
+ *              int height: integer storing the number of rows contained in the
+ *                          UArray2m
+ *              int size: integer storing the size (in bytes) of each element
+ *                        in the new UArray2m
+ * Return: A new UArray2m with width x height number of elements, each of which
+ *         are of size bytes, stored in Z-order
+ * Expects:
+ *      * width and height to be nonnegative
+ *      * size to be positive
+ * Notes:
+ *      Checked runtime error if:
+ *              * width or height is negative
+ *              * size is nonpositive
+ *              * the storage for the cells cannot be allocated
+ *      The client must free heap allocated memory using UArray2m_free
+ ************************/
+T UArray2m_new(int width, int height, int size)
+{
+        T array2m = malloc(sizeof(*array2m));
+        assert(array2m != NULL);
+        assert(width >= 0);
+        assert(height >= 0);
+        assert(size > 0);
+
+        array2m->width = width;
+        array2m->height = height;
+        array2m->size = size;
+        array2m->wide = width >= height;
+
+        int shorter = array2m->wide ? height : width;
+        int longer = array2m->wide ? width : height;
+        int k = 0;
+        while ((1 << k) < shorter) {
+                k++;
+        }
+        array2m->log_side = k;
+        array2m->squares = (longer + (1 << k) - 1) >> k;
+
+        array2m->nbytes = ((size_t)array2m->squares << (2 * k)) * size;
+        array2m->elems = Pixmem_alloc(array2m->nbytes, &array2m->mapped);
+
+        return array2m;
+}
+
+/**********UArray2m_free********
+ *
+ * Deallocates and clears the *UArray2m
+ * Inputs:
+ *              T *array2m: Pointer to a pointer to the UArray2m that will be
+ *                          deallocated and cleared
+ * Return: N/A
+ * Expects:
+ *      UArray2m or *UArray2m to be nonnull
+ * Notes:
+ *      Checked runtime error if UArray2m / *UArray2m is null
+ ************************/
+void UArray2m_free(T *array2m)
+{
+        assert(array2m != NULL && *array2m != NULL);
+        Pixmem_free((*array2m)->elems, (*array2m)->nbytes, 
+                                                        (*array2m)->mapped);
+        free(*array2m);
+        *array2m = NULL;
+}
+
+/**********UArray2m_width********
+ *
+ * Returns the number of columns in the UArray2m
+ * Expects:
+ *       Pointer to the UArray2m to be nonnull
+ ************************/
+int UArray2m_width(T array2m)
+{
+        assert(array2m != NULL);
+        return array2m->width;
+}
+
+/**********UArray2m_height********
+ *
+ * Returns the number of rows in the UArray2m
+ * Expects:
+ *       Pointer to the UArray2m to be nonnull
+ ************************/
+int UArray2m_height(T array2m)
+{
+        assert(array2m != NULL);
+        return array2m->height;
+}
+
+/**********UArray2m_size********
+ *
+ * Returns the size, in bytes, of each element in the UArray2m
+ * Expects:
+ *       Pointer to the UArray2m to be nonnull
+ ************************/
+int UArray2m_size(T array2m)
+{
+        assert(array2m != NULL);
+        return array2m->size;
+}
+
+/**********UArray2m_at********
+ *
+ * Returns a pointer to the element within the UArray2m at the indices
+ * (col, row)
+ * Inputs:
+ *              T array2m: A pointer to the UArray2m in which the element is to
+ *                         be located
+ *              int col: The column index of the element within the UArray2m
+ *              int row: The row index of the element within the UArray2m
+ * Return: A pointer to the element within the UArray2m that is in the
+ *         indices (col, row)
+ * Expects:
+ *      * The row value is positive and is less than the height of the UArray2m
+ *      * The col value is positive and is less than the width of the UArray2m
+ * Notes:
+ *      * Checked runtime error if:
+ *              * UArray2m is null
+ *              * row value >= height or row value < 0
+ *              * col value >= width or col value < 0
+ ************************/
+void *UArray2m_at(T array2m, int col, int row)
+{
+        assert(array2m != NULL);
+        assert(row >= 0 && row < array2m->height);
+        assert(col >= 0 && col < array2m->width);
+        return array2m->elems + morton_index(array2m, col, row) *
+                                                                array2m->size;
+}
+
+/*
+ * closure used to carry the client's apply function through the recursive
+ * walk of the Z-order curve
+ */
+struct walk {
+        T array2m;
+        void (*apply)(int col, int row, T array2m, void *elem, void *cl);
+        void *cl;
+};
+
+/**********walk_quadrant********
+ *
+ * Visits the cells of the side x side quadrant whose top left cell is at
+ * (col, row) and whose first cell is stored at elem, in Z-order. Quadrants
+ * lying entirely outside the array (padding) are skipped without being
+ * visited.
+ ************************/
+static void walk_quadrant(struct walk *w, int col, int row, int side,
+                          char *elem)
+{
+        T array2m = w->array2m;
+        if (col >= array2m->width || row >= array2m->height) {
+                return;
+        }
+        if (side == 1) {
+                w->apply(col, row, array2m, elem, w->cl);
+                return;
+        }
+        int half = side / 2;
+        size_t quarter = (size_t)half * half * array2m->size;
+        walk_quadrant(w, col,        row,        half, elem);
+        walk_quadrant(w, col + half, row,        half, elem + quarter);
+        walk_quadrant(w, col,        row + half, half, elem + 2 * quarter);
+        walk_quadrant(w, col + half, row + half, half, elem + 3 * quarter);
+}
+
+/**********UArray2m_map********
+ *
+ * Calls an apply function for each element in UArray2m, in the order the
+ * elements are stored (along the Z-order curve, one square tile at a time)
+ * Inputs:
+ *              T array2m: A pointer to the UArray2m that the apply function
+ *                         will be called on
+ *              void apply: The function that will be applied to each element
+ *                          in UArray2m, given the element's column, row, the
+ *                          UArray2m, a pointer to the element and cl
+ *              void *cl: A closure passed in by the client to be used in the
+ *                        apply function
+ * Return: N/A
+ * Expects:
+ *      * UArray2m to be nonnull
+ * Notes:
+ *      Checked runtime error if UArray2m is null
+ ************************/
+void UArray2m_map(T array2m, void apply(int col, int row, T array2m,
+                                        void *elem, void *cl), void *cl)
+{
+        assert(array2m != NULL);
+        struct walk w = { array2m, apply, cl };
+        int side = 1 << array2m->log_side;
+        size_t square_bytes = (size_t)side * side * array2m->size;
+        for (int s = 0; s < array2m->squares; s++) {
+                int col = array2m->wide ? s * side : 0;
+                int row = array2m->wide ? 0 : s * side;
+                walk_quadrant(&w, col, row, side,
+                                        array2m->elems + s * square_bytes);
+        }
+}
+
+/*
+ * closure used by gather_cell: the UArray2m being read and the affine form
+ * of the op that takes a cell of the UArray2m being written back to it
+ */
+struct gather {
+        T src;
+        Dihedral_steps from;
+};
+
+/**********gather_cell********
+ *
+ * Apply function that fills a cell of the destination of UArray2m_transform
+ * with the source cell that lands on it
+ ************************/
+static void gather_cell(int col, int row, T dst, void *elem, void *vcl)
+{
+        struct gather *g = vcl;
+        const Dihedral_steps *from = &g->from;
+        int src_col = from->col0 + col * from->dcol_col + row * from->dcol_row;
+        int src_row = from->row0 + col * from->drow_col + row * from->drow_row;
+        memcpy(elem, g->src->elems + morton_index(g->src, src_col, src_row) *
+                                                g->src->size, dst->size);
+}
+
+/**********UArray2m_transform********
+ *
+ * Copies every cell of one UArray2m to its place in another under one of 
+ * the eight symmetries of a rectangle
+ * Inputs:
+ *              T src: the UArray2m to transform
+ *              T dst: the UArray2m that receives the transformed cells
+ *              Dihedral_op op: where each cell goes (see dihedral.h)
+ * Return: N/A
+ * Expects:
+ *      * src and dst to be nonnull, distinct and to have the same cell size
+ *      * dst to be src->height x src->width if op swaps the dimensions, and 
+ *        src->width x src->height otherwise
+ * Notes:
+ *      * Checked runtime error if any expectation is not met
+ *      * The destination is walked along its Z-order curve and each cell is
+ *        gathered from the source. Every op sends a quadrant of one array to
+ *        a quadrant of the other, so the reads are as local as the writes at
+ *        every scale and the writes are kept in storage order.
+ ************************/
+void UArray2m_transform(T src, T dst, Dihedral_op op)
+{
+        assert(src != NULL && dst != NULL && src != dst);
+        assert(src->size == dst->size);
+        assert(Dihedral_swaps(op) 
+                ? dst->width == src->height && dst->height == src->width
+                : dst->width == src->width && dst->height == src->height);
+        struct gather g = { src, Dihedral_steps_of(Dihedral_inverse(op), 
+                                                   dst->width, dst->height) };
+        UArray2m_map(dst, gather_cell, &g);
+}
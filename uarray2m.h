@@ -0,0 +1,41 @@
+/*
+ *     uarray2m.h
+ *     by Kabir Pamnani and Alex Shriver, 10/16/2026
+ *     HW3: Locality
+ *
+ *     Summary: Interface for 2D Unboxed Arrays stored in Morton (Z-order)
+ *              layout
+ */
+
+#ifndef UARRAY2M_INCLUDED
+#define UARRAY2M_INCLUDED
+#include "dihedral.h"
+
+#define T UArray2m_T
+typedef struct T *T;
+
+/* 
+ * new Morton-ordered 2d array: cells are stored along a Z-order curve, so
+ * cells that are close in both the column and the row direction are close 
+ * in memory at every scale
+ */
+extern T UArray2m_new(int width, int height, int size);
+extern void UArray2m_free(T *array2m);
+extern int UArray2m_width(T array2m);
+extern int UArray2m_height(T array2m);
+extern int UArray2m_size(T array2m);
+extern void *UArray2m_at(T array2m, int col, int row);
+
+/* visits every cell in the order it is stored, ie along the Z-order curve */
+extern void UArray2m_map(T array2m, void apply(int col, int row, T array2m, 
+                                        void *elem, void *cl), void *cl);
+
+/* 
+ * copies each cell of src to its place in dst under op, which must be 
+ * distinct from src, have the same cell size and have src's dimensions 
+ * (swapped if Dihedral_swaps(op)), walking dst along its Z-order curve
+ */
+extern void UArray2m_transform(T src, T dst, Dihedral_op op);
+
+#undef T
+#endif